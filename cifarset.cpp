@@ -121,15 +121,15 @@ const float* CifarSet::getNoisyImage(
     if (p_processed_.size() != width() * height())
         p_processed_.resize(width() * height());
 
-    const float * img = image(index);
-    for (auto& p : p_processed_)
-    {
-        float pix = *img++;
-
-        pix += MNN::rnd(minRnd, maxRnd);
-
-        p = pix;
-    }
-
+    getNoisyImage(index, minRnd, maxRnd, &p_processed_[0]);
     return &p_processed_[0];
 }
+
+void CifarSet::getNoisyImage(
+    uint32_t index, float minRnd, float maxRnd, float* output) const
+{
+    const size_t num = width() * height();
+    const float * img = image(index);
+    std::copy(img, img + num, output);
+    MNN::Random::local().addUniform(output, num, minRnd, maxRnd);
+}
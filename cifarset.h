@@ -35,6 +35,10 @@ public:
     /** @note Returned pointer is valid until next call to this function. */
     const float* getNoisyImage(
             uint32_t index, float minRnd, float maxRnd);
+    /** Thread-safe version, writing width() * height() values to @p output.
+        The noise is taken from MNN::Random::local(). */
+    void getNoisyImage(
+            uint32_t index, float minRnd, float maxRnd, float* output) const;
 
     /** Returns the next random sample number with a different label */
     uint32_t nextRandomSample(uint32_t index) const;
@@ -12,6 +12,7 @@
 #define RBM_STACK_H
 
 #include <iomanip>
+#include <memory>
 
 #include "mnn/mnn.h"
 
@@ -29,19 +30,26 @@
 template <typename Float, class Rbm>
 class RbmStack
 {
-public:
-    struct Sample
-    {
-        Sample() : err_cd(0.), err_rec(0.) { }
-        std::vector<Float> data;
-        Float err_cd, err_rec;
-    };
-
-private:
     std::vector<size_t> numCells_;
     std::vector<Rbm*> rbm_;
-    std::vector<Sample*> samples_, higherSamples_;
-    const size_t cdSteps_ = 50;
+    /** Row-major matrix of numSamples_ x numIn(), either
+        sampleMem_ or external memory, see setSamples() */
+    const Float* sampleData_;
+    size_t numSamples_;
+    std::vector<Float> sampleMem_,
+    /** Last contrastive divergence error of each sample */
+        sampleErrorCd_;
+    std::vector<size_t> batchIndex_;
+    /** Output of the first numFeatureLayers_ layers for each sample */
+    MNN::FeatureMatrix<Float> features_, nextFeatures_;
+    size_t numFeatureLayers_;
+    bool mapFeatures_;
+    std::unique_ptr<MNN::ThreadPool> pool_;
+    std::vector<Float> batch_;
+    /** Gibbs steps per update of the persistent chains */
+    const size_t cdSteps_ = 5;
+    /** Number of Gibbs chains per contrastive divergence step */
+    const size_t batchSize_ = 16;
     const Float learnRate_ = 0.01;
     const Float momentum_ = .5;
 public:
@@ -50,6 +58,10 @@ public:
     size_t epoch, err_count;
 
     RbmStack()
+        : sampleData_       (nullptr)
+        , numSamples_       (0)
+        , numFeatureLayers_ (0)
+        , mapFeatures_      (false)
     {
         resetErrorStats();
     }
@@ -76,10 +88,30 @@ public:
         return str.str();
     }
 
-    const std::vector<Sample*>& samples() const { return samples_; }
+    size_t numSamples() const { return numSamples_; }
+
+    /** The numIn() values of sample @p index */
+    const Float* sample(size_t index) const { return sampleData_ + index * numIn(); }
+
+    /** Last contrastive divergence error of sample @p index */
+    Float sampleErrorCd(size_t index) const { return sampleErrorCd_[index]; }
+
+    void clearSamples()
+    {
+        sampleData_ = nullptr;
+        numSamples_ = 0;
+        std::vector<Float>().swap(sampleMem_);
+        std::vector<Float>().swap(sampleErrorCd_);
+        clearHigherSamples();
+    }
+    void clearHigherSamples()
+        { features_.clear(); nextFeatures_.clear(); numFeatureLayers_ = 0; }
+
+    /** Output of the last layer in createHigherSamples() for each sample */
+    const MNN::FeatureMatrix<Float>& features() const { return features_; }
 
-    void clearSamples() { for (auto s : samples_) delete s; samples_.clear(); }
-    void clearHigherSamples() { for (auto s : higherSamples_) delete s; higherSamples_.clear(); }
+    /** Keeps the features in memory-mapped files, see featureFilename() */
+    void setMapFeatures(bool enable) { mapFeatures_ = enable; }
 
     size_t numIn() const { return numCells_.empty() ? 0 : numCells_[0]; }
 
@@ -91,17 +123,33 @@ public:
             auto rbm = new Rbm(numCells[i-1], numCells[i]);
             rbm->brainwash();
             rbm->setMomentum(momentum_);
+            rbm->setPersistent(true);
             rbm_.push_back(rbm);
         }
     }
 
+    /** Copies numIn() values of @p s to the end of the samples */
     void addSample(const Float* s)
     {
-        auto sam = new Sample;
-        sam->data.resize(numIn());
-        for (auto& f : sam->data)
-            f = *s++;
-        samples_.push_back(sam);
+        // copy external samples first
+        if (sampleData_ != sampleMem_.data())
+            sampleMem_.assign(sampleData_, sampleData_ + numSamples_ * numIn());
+
+        sampleMem_.insert(sampleMem_.end(), s, s + numIn());
+        sampleData_ = sampleMem_.data();
+        ++numSamples_;
+        sampleErrorCd_.push_back(0);
+    }
+
+    /** Uses the @p num samples in @p data, one after another, without copying.
+        @p data must stay valid until clearSamples() or the next setSamples(),
+        e.g. MnistSet::image(0) */
+    void setSamples(const Float* data, size_t num)
+    {
+        clearSamples();
+        sampleData_ = data;
+        numSamples_ = num;
+        sampleErrorCd_.assign(num, 0);
     }
 
     std::string layerFilename(size_t index) const
@@ -111,31 +159,51 @@ public:
         return str.str();
     }
 
+    std::string featureFilename(size_t index) const
+    {
+        std::stringstream str;
+        str << "rbm_features_" << index << ".bin";
+        return str.str();
+    }
+
     void loadLayer(size_t index)
     {
         rbm_[index]->loadTextFile(layerFilename(index));
+        invalidateFeatures_(index);
         LOG("loaded rbm layer " << index << " (" << layerFilename(index) << ")");
         rbm_[index]->info();
     }
 
-    /** Creates the net output for each sample_ into higherSamples_ */
+    /** Creates the output of layer @p index for each sample into features().
+        If features() holds the output of layer index - 1, only layer
+        @p index is run on it, otherwise all samples are streamed through
+        the layers 0 to @p index. The rows are computed in parallel. */
     void createHigherSamples(size_t index)
     {
         LOG("creating output for each sample for layer " << index);
-        clearHigherSamples();
+        if (!pool_)
+            pool_.reset(new MNN::ThreadPool());
 
-        if (index == 0)
-        for (size_t i = 0; i < samples_.size(); ++i)
+        if (index > 0 && numFeatureLayers_ == index)
+        {
+            // continue from the previous layer's features
+            prepareFeatures_(nextFeatures_, index, features_.numRows());
+            nextFeatures_.compute({ rbm_[index] }, features_.numRows(),
+                                  [this](size_t i) { return features_.row(i); },
+                                  pool_.get());
+            features_.swap(nextFeatures_);
+            nextFeatures_.clear();
+        }
+        else
         {
-            // get space for output
-            auto hsam = new Sample;
-            higherSamples_.push_back(hsam);
-            hsam->data.resize(rbm_[index]->numOut());
-            // prob first layer
-            rbm_[0]->fprop(&samples_[i]->data[0], &hsam->data[0]);
+            std::vector<const MNN::Layer<Float>*>
+                    layers(rbm_.begin(), rbm_.begin() + index + 1);
+            prepareFeatures_(features_, index, numSamples_);
+            features_.compute(layers, numSamples_,
+                              [this](size_t i) { return sample(i); },
+                              pool_.get());
         }
-        // XXX higher levels missing
-        else abort();
+        numFeatureLayers_ = index + 1;
     }
 
     void trainLayerLoop(size_t index, size_t maxEpoch = 300000)
@@ -162,33 +230,82 @@ public:
         LOG("saved layer #" << index << " as '" << layerFilename(index) << "'");
     }
 
-    void trainStep(size_t index)
+    /** Trains all layers at once, each on it's own thread.
+        Layer k + 1 trains on the samples propagated through
+        a snapshot of the layers below, which is refreshed
+        every @p refreshInterval steps, see MNN::LayerwiseTrainer. */
+    void trainLayersOverlapped(size_t maxEpoch = 300000, size_t refreshInterval = 1000)
     {
-        Rbm* rbm = rbm_[index];
+        LOG("\n------ TRAIN " << rbm_.size() << " LAYERS OVERLAPPED ------");
+
+        MNN::LayerwiseTrainer<Float> trainer;
+        trainer.setSamples(numSamples_, [this](size_t i) { return sample(i); });
+        trainer.setBatchSize(batchSize_);
+        trainer.setSnapshotInterval(refreshInterval);
+        trainer.setRefreshInterval(refreshInterval);
+        trainer.setStartDelay(refreshInterval);
+        for (auto rbm : rbm_)
+            trainer.addLayer(rbm, maxEpoch,
+                             [this](MNN::Layer<Float>& l, const Float* input, size_t num)
+            {
+                return static_cast<Rbm&>(l).contrastiveDivergenceBatch(
+                            input, num, cdSteps_, learnRate_);
+            });
+        trainer.setReportInterval(1000);
+        trainer.setReportFunc([this](size_t index, const MNN::LayerwiseStats& s)
+        {
+            LOG("layer " << index << " step " << std::left << std::setw(9) << s.numSteps
+                << " av " << std::setw(9) << s.averageError()
+                << " avweight " << rbm_[index]->getWeightAverage());
+        });
 
-        // -- choose sample --
+        trainer.run();
 
-        Sample * sample;
-        // real-data -> first layer
-        if (index == 0)
+        for (size_t i = 0; i < rbm_.size(); ++i)
         {
-            size_t samIndex = size_t(rand()) % samples_.size();
-            sample = samples_[samIndex];
+            rbm_[i]->saveTextFile(layerFilename(i));
+            LOG("saved layer #" << i << " as '" << layerFilename(i) << "'");
         }
-        // layer n-1 -> n
-        else
+        clearHigherSamples();
+    }
+
+    void trainStep(size_t index)
+    {
+        Rbm* rbm = rbm_[index];
+
+        // -- choose samples --
+
+        // features that went through this layer get outdated
+        invalidateFeatures_(index);
+
+        // real-data -> first layer, layer n-1 -> n
+        const bool fromSamples = index == 0;
+        if (!fromSamples && numFeatureLayers_ != index)
+            createHigherSamples(index - 1);
+        const size_t numSet = fromSamples ? numSamples_ : features_.numRows();
+
+        const size_t numIn = rbm->numIn();
+        batch_.resize(batchSize_ * numIn);
+        batchIndex_.resize(batchSize_);
+        for (size_t b = 0; b < batchSize_; ++b)
         {
-            size_t samIndex = size_t(rand()) % higherSamples_.size();
-            sample = higherSamples_[samIndex];
+            size_t samIndex = MNN::Random::local().index(numSet);
+            batchIndex_[b] = samIndex;
+            const Float* src = fromSamples ? sample(samIndex)
+                                           : features_.row(samIndex);
+            std::copy(src, src + numIn, &batch_[b * numIn]);
         }
 
-        // contrastive divergence training
-        Float err = rbm->contrastiveDivergence(&sample->data[0], cdSteps_, learnRate_);
+        // contrastive divergence training of all chains at once
+        Float err = rbm->contrastiveDivergenceBatch(
+                    &batch_[0], batchSize_, cdSteps_, learnRate_);
         ++epoch;
 
         // -- gather error stats --
 
-        sample->err_cd = err;
+        if (fromSamples)
+            for (auto i : batchIndex_)
+                sampleErrorCd_[i] = err;
 
         if (epoch % 1000 == 0 && err_min >= 0.)
         {
@@ -214,6 +331,23 @@ public:
             }
         }
     }
+
+private:
+
+    /** Drops the features if they contain the output of layer @p index */
+    void invalidateFeatures_(size_t index)
+    {
+        if (index < numFeatureLayers_)
+            clearHigherSamples();
+    }
+
+    void prepareFeatures_(MNN::FeatureMatrix<Float>& f, size_t index, size_t numRows)
+    {
+        if (mapFeatures_)
+            f.resizeMapped(featureFilename(index), numRows, rbm_[index]->numOut());
+        else
+            f.resize(numRows, rbm_[index]->numOut());
+    }
 };
 
 #endif // RBM_STACK_H
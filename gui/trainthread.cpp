@@ -60,14 +60,13 @@ void TrainThread::run()
             rbms_.setSize(sizeRequest_);
             sizeRequest_.clear();
 
-            // copy samples
-            for (size_t i=0; i<mnist.numSamples(); ++i)
-                rbms_.addSample(mnist.image(i));
+            // use samples without copying
+            rbms_.setSamples(mnist.image(0), mnist.numSamples());
 
             emit rbmChanged();
         }
 
-        if (doPause_ || rbms_.samples().empty())
+        if (doPause_ || rbms_.numSamples() == 0)
         {
             msleep(50);
             continue;
@@ -78,5 +77,9 @@ void TrainThread::run()
         for (int i=0; i<16; ++i)
             rbms_.trainStep(trainLayerIndex_);
     }
+
+    // samples point into mnist
+    QWriteLocker lock(mutex_);
+    rbms_.clearSamples();
 }
 
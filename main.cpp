@@ -305,14 +305,19 @@ private:
     std::vector<size_t> numCells_;
     std::vector<Rbm*> rbm_;
     MNN::StackSerial<Float> stack_;
-    std::vector<Sample*> samples_, higherSamples_;
+    std::vector<Sample*> samples_;
+    /** Output of a layer for each sample */
+    MNN::FeatureMatrix<Float> features_;
+    MNN::ThreadPool pool_;
+    /** Writes the layer files in the background */
+    MNN::Checkpointer<Float> checkpointer_;
     const size_t cdSteps_ = 4;
     const Float learnRate_ = 0.05;
     const Float momentum_ = .7;
 public:
 
     void clearSamples() { for (auto s : samples_) delete s; samples_.clear(); }
-    void clearHigherSamples() { for (auto s : higherSamples_) delete s; higherSamples_.clear(); }
+    void clearHigherSamples() { features_.clear(); }
 
     size_t numIn() const { return numCells_.empty() ? 0 : numCells_[0]; }
 
@@ -347,46 +352,22 @@ public:
 
     void loadLayer(size_t index)
     {
+        checkpointer_.wait();
         rbm_[index]->loadTextFile(layerFilename(index));
         std::cout << "loaded rbm layer " << index << " ("
                   << layerFilename(index) << ")\n";
         rbm_[index]->info();
     }
 
-    /** Creates the net output for each sample_ into higherSamples_ */
+    /** Creates the output of layer @p index for each sample_ into features_ */
     void createHigherSamples(size_t index)
     {
         LOG("creating output for each sample for layer " << index);
-        clearHigherSamples();
-        if (index == 0)
-        {
-            for (size_t i = 0; i < samples_.size(); ++i)
-            {
-                // get space for output
-                auto hsam = new Sample;
-                higherSamples_.push_back(hsam);
-                hsam->data.resize(rbm_[index]->numOut());
-                // prop first layer
-                rbm_[0]->fprop(&samples_[i]->data[0], &hsam->data[0]);
-            }
-        }
-        else
-        {
-            std::vector<Float> output(stack_.numOut());
-            for (size_t i = 0; i < samples_.size(); ++i)
-            {
-                // get space for output
-                auto hsam = new Sample;
-                higherSamples_.push_back(hsam);
-                hsam->data.resize(rbm_[index]->numOut());
-
-                // prop whole stack
-                stack_.fprop(&samples_[i]->data[0], &output[0]);
-                // get output from specific layer
-                for (size_t j=0; j<hsam->data.size(); ++j)
-                    hsam->data[j] = rbm_[index]->output(j);
-            }
-        }
+        std::vector<const MNN::Layer<Float>*>
+                layers(rbm_.begin(), rbm_.begin() + index + 1);
+        features_.compute(layers, samples_.size(),
+                          [this](size_t i) { return &samples_[i]->data[0]; },
+                          &pool_);
     }
 
     void trainLayer(size_t index, size_t maxEpoch = 300000)
@@ -402,24 +383,27 @@ public:
         {
             // -- choose sample --
 
-            Sample * sample;
+            Sample * sample = 0;
+            const Float * input;
             // real-data -> first layer
             if (index == 0)
             {
                 size_t samIndex = size_t(rand()) % samples_.size();
                 sample = samples_[samIndex];
+                input = &sample->data[0];
             }
             // layer n-1 -> n
             else
             {
-                size_t samIndex = size_t(rand()) % higherSamples_.size();
-                sample = higherSamples_[samIndex];
+                size_t samIndex = size_t(rand()) % features_.numRows();
+                input = features_.row(samIndex);
             }
 
             // contrastive divergance training
-            Float err = rbm->contrastiveDivergence(&sample->data[0], cdSteps_, learnRate_);
+            Float err = rbm->contrastiveDivergence(input, cdSteps_, learnRate_);
             //err = err / (rbm->numOut() * rbm->numIn()) * 100;
-            sample->err_cd = err;
+            if (sample)
+                sample->err_cd = err;
 
             // gather error stats
             if (err_min < 0.)
@@ -449,7 +433,7 @@ public:
                         (last_save_err < 0. || err_max < last_save_err))
                 {
                     last_save_err = err_max;
-                    rbm->saveTextFile(layerFilename(index));
+                    checkpointer_.save(*rbm, layerFilename(index));
                     LOG("saved layer #" << index << " as '" << layerFilename(index) << "'");
                 }
 
@@ -462,6 +446,7 @@ public:
                 err_count = 0;
             }
         }
+        checkpointer_.wait();
     }
 };
 
@@ -721,6 +706,7 @@ void trainRecon()
     size_t epoch = 0, err_count = 0;
     Float err_sum = 0., err_min = -1., err_max = 0.,
           lastWeights = 0., last_av_err = -1.;
+    MNN::Checkpointer<Float> checkpointer;
     while (true)
     {
         uint32_t index = uint32_t(rand()) % set.numSamples();
@@ -790,7 +776,7 @@ void trainRecon()
             if (!saveFilename.empty())
             if (last_av_err >= 0 && av_err < last_av_err)
             {
-                layer->saveTextFile(saveFilename);
+                checkpointer.save(*layer, saveFilename);
             }
 #endif
             //printStateAscii(net->weights(), set.width(), set.height(), 8.f);
@@ -825,84 +811,112 @@ void trainAutoencoderStack()
 #endif
     size_t numIn = set.width() * set.height();
 
-    auto net = new MNN::StackSerial<Float>();
-
-    auto layer = new MNN::FeedForward<Float, MNN::Activation::Linear>(
-                    numIn, numIn * 2    , 1, false);
-    layer->setMomentum(.9);
-    layer->brainwash(0.1);
-    Float learnRate = 0.0009;
-
-    layer->info();
-
-    std::vector<Float> buffer;
-
-    size_t epoch = 0, err_count = 0;
-    Float err_sum = 0., err_min = -1., err_max = 0.,
-          lastWeights = 0.;
-    while (true)
+    // first layer doubles the size, then shrink down to 100 cells
+    std::vector<size_t> sizes = { numIn, numIn * 2 };
+    while (size_t(sizes.back() * sizeScale) >= 100)
+        sizes.push_back(sizes.back() * sizeScale);
+
+    typedef MNN::FeedForward<Float, MNN::Activation::Linear> AeLayer;
+    const Float learnRate = 0.0009;
+
+    // all layers train at once, layer k+1 on snapshots of layer k
+    MNN::LayerwiseTrainer<Float> trainer;
+    trainer.setSamples(set.numSamples(), [&](size_t i) { return set.image(i); });
+    trainer.setSnapshotInterval(5000);
+    trainer.setRefreshInterval(5000);
+    trainer.setStartDelay(20000);
+
+    // the layers are only stacked when trained,
+    // a StackSerial would share their inputs and outputs
+    std::vector<AeLayer*> layers;
+    for (size_t i = 1; i < sizes.size(); ++i)
     {
-        // get training sample
-        uint32_t index = uint32_t(rand()) % set.numSamples();
-        const Float* image = set.image(index);
-
-        // propagate through already trained stack
-        if (net->numLayer())
+        auto layer = new AeLayer(sizes[i-1], sizes[i], 1, false);
+        layer->setMomentum(.9);
+        layer->brainwash(0.1);
+        layer->info();
+        layers.push_back(layer);
+
+        // stop when the weights hardly change anymore
+        Float lastWeight = layer->getWeightAverage();
+        trainer.addLayer(layer, 1000000,
+                         [=](MNN::Layer<Float>& l, const Float* input, size_t)
         {
-            if (buffer.size() != net->numOut())
-                buffer.resize(net->numOut());
-            net->fprop(image, &buffer[0]);
-            image = &buffer[0];
-        }
+            return 100. * static_cast<AeLayer&>(l).reconstructionTraining(input, learnRate);
+        },
+                         [=](const MNN::Layer<Float>& l, const MNN::LayerwiseStats& s) mutable
+        {
+            Float weight = l.getWeightAverage(),
+                  weightInc = std::abs(weight - lastWeight);
+            lastWeight = weight;
+            return weightInc / learnRate < 0.01 && s.numSteps > 120000;
+        });
+    }
 
-        Float error = 100. * layer->reconstructionTraining(image, learnRate);
-        ++epoch;
+    trainer.setReportInterval(5000);
+    trainer.setReportFunc([&](size_t index, const MNN::LayerwiseStats& s)
+    {
+        LOG("layer " << index
+            << " epoch " << std::left << std::setw(8) << s.numSteps
+            << " error av " << std::setw(9) << s.averageError()
+            << " weights " << std::setw(9) << layers[index]->getWeightAverage()
+            );
+    });
 
-        err_sum += error;
-        if (err_min < 0. || error < err_min)
-            err_min = error;
-        err_max = std::max(err_max, error);
-        ++err_count;
+    MNN::Checkpointer<Float> checkpointer;
+    trainer.setFinishedFunc([&](size_t index, const MNN::Layer<Float>& l)
+    {
+        LOG("layer " << index << " finished");
+        std::stringstream fn;
+        fn << "../autoencoder-stack-cifar-layer" << index << ".txt";
+        checkpointer.save(l, fn.str());
+    });
 
-        if (epoch % 5000 == 0)
-        {
-            Float weightAv = layer->getWeightAverage(),
-                  weightInc = weightAv - lastWeights;
-            LOG("epoch " << std::left << std::setw(8) << epoch
-                << " error " << std::setw(9) << err_min
-                << " - " << std::setw(9) << err_max
-                << " av " << std::setw(9) << (err_sum / err_count)
-                << " weights " << std::setw(9) << weightAv
-                << " inc " << std::setw(9) << (weightInc / learnRate)
-                );
+    trainer.run();
 
-            lastWeights = weightAv;
-            err_sum = err_max = 0.;
-            err_min = -1.;
-            err_count = 0;
+    auto net = new MNN::StackSerial<Float>();
+    for (auto l : layers)
+        net->add(l);
+    net->saveTextFile("../autoencoder-stack-cifar.txt");
+    checkpointer.wait();
+}
 
-            // finished training this layer?
-            if (weightInc / learnRate < 0.01
-                && epoch > 120000)
-            {
-                net->add(layer);
-                net->saveTextFile("../autoencoder-stack-cifar.txt");
 
-                size_t newOut = net->numOut() * sizeScale;
-                if (newOut < 100)
-                    break;
+/** Checks that a Layer::getCopy() snapshot keeps it's values
+    while MNN::ModelAveraging trains the original network */
+template <typename Float>
+void testSnapshot()
+{
+    MNN::StackSerial<Float> net;
+    net.add(new MNN::FeedForward<Float, MNN::Activation::Tanh>(4, 3));
+    net.add(new MNN::FeedForward<Float, MNN::Activation::Linear>(3, 2));
+    net.brainwash(0.5);
 
-                layer = new MNN::FeedForward<Float, MNN::Activation::Linear>(
-                            net->numOut(), newOut, 1, false);
-                layer->setMomentum(.9);
-                layer->brainwash(0.1);
+    MNN::ModelAveraging<Float> par(net, 2);
 
-                layer->info();
+    std::unique_ptr<MNN::Layer<Float>> snapshot(net.getCopy());
+    std::stringstream before;
+    snapshot->serialize(before);
 
-                epoch = 0;
-            }
+    const std::vector<Float> input({ 0.1, 0.9, 0.5, 0.3 }),
+                             target({ 0.7, -0.2 });
+    for (int i = 0; i < 3; ++i)
+    par.step(4, [&](MNN::Layer<Float>& l, size_t, size_t begin, size_t end)
+    {
+        std::vector<Float> out(l.numOut()), err(l.numOut());
+        for (size_t j = begin; j < end; ++j)
+        {
+            l.fprop(input.data(), out.data());
+            for (size_t k = 0; k < out.size(); ++k)
+                err[k] = target[k] - out[k];
+            l.bprop(err.data());
         }
-    }
+    });
+
+    std::stringstream after;
+    snapshot->serialize(after);
+    LOG("snapshot " << (before.str() == after.str()
+                        ? "kept it's values" : "CHANGED by ModelAveraging::step()"));
 }
 
 
@@ -922,6 +936,7 @@ void testCifar()
 int main()
 {
 	srand(time(NULL));
+    MNN::Random::setSeed(time(NULL));
 
     //auto l = MNN::Factory<float>::createLayer("feed_forward", "linear_rectified");
     //auto l = MNN::Factory<float>::loadTextFile("../mnist_e400_stack.txt");
@@ -935,6 +950,7 @@ int main()
     //trainRbmPyramid();
 
     //testCifar();
+    //testSnapshot<float>();
     //trainRecon<float>();
     //trainAutoencoderStack<float>();
 
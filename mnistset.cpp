@@ -129,8 +129,17 @@ const float* MnistSet::getNoisyBackgroundImage(
     if (p_processed_.size() != width() * height())
         p_processed_.resize(width() * height());
 
+    getNoisyBackgroundImage(index, backgroundThreshold, minRnd, maxRnd,
+                            &p_processed_[0]);
+    return &p_processed_[0];
+}
+
+void MnistSet::getNoisyBackgroundImage(
+    uint32_t index, float backgroundThreshold, float minRnd, float maxRnd,
+    float* output) const
+{
     const float * img = image(index);
-    for (auto& p : p_processed_)
+    for (uint32_t i = 0; i < width() * height(); ++i)
     {
         float pix = *img++;
 
@@ -139,10 +148,8 @@ const float* MnistSet::getNoisyBackgroundImage(
             pix = MNN::rnd(minRnd, maxRnd);
         }
 
-        p = pix;
+        output[i] = pix;
     }
-
-    return &p_processed_[0];
 }
 
 const float* MnistSet::getNoisyImage(
@@ -151,25 +158,32 @@ const float* MnistSet::getNoisyImage(
     if (p_processed_.size() != width() * height())
         p_processed_.resize(width() * height());
 
-    const float * img = image(index);
-    for (auto& p : p_processed_)
-    {
-        float pix = *img++;
-
-        pix += MNN::rnd(minRnd, maxRnd);
-
-        p = pix;
-    }
-
+    getNoisyImage(index, minRnd, maxRnd, &p_processed_[0]);
     return &p_processed_[0];
 }
 
+void MnistSet::getNoisyImage(
+    uint32_t index, float minRnd, float maxRnd, float* output) const
+{
+    const size_t num = width() * height();
+    const float * img = image(index);
+    std::copy(img, img + num, output);
+    MNN::Random::local().addUniform(output, num, minRnd, maxRnd);
+}
+
 const float* MnistSet::getTransformedImage(
     uint32_t index, float rndMorph)
 {
     if (p_processed_.size() != width() * height())
         p_processed_.resize(width() * height());
 
+    getTransformedImage(index, rndMorph, &p_processed_[0]);
+    return &p_processed_[0];
+}
+
+void MnistSet::getTransformedImage(
+    uint32_t index, float rndMorph, float* output) const
+{
     const float * img = image(index);
 
     float freqx = MNN::rnd(0., 10.),
@@ -193,7 +207,7 @@ const float* MnistSet::getTransformedImage(
                   fx = x - ix,
                   fy = y - iy;
             if (ix < 0. || ix >= width() || iy < 0. || iy >= height())
-                p_processed_[py * height() + px] = backg;
+                output[py * height() + px] = backg;
             else
             {
                 float v = img[int(iy * height() + ix)];
@@ -206,12 +220,10 @@ const float* MnistSet::getTransformedImage(
                         v1 += fx * (img[int((iy+1) * height() + ix + 1)] - v1);
                     v += fy * (v1 - v);
                 }
-                p_processed_[py * height() + px] = v;
+                output[py * height() + px] = v;
             }
         }
     }
-
-    return &p_processed_[0];
 }
 
 
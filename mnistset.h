@@ -46,6 +46,17 @@ public:
 
     const float* getTransformedImage(uint32_t index, float maxMorphPixels);
 
+    /** Thread-safe versions of the above, writing
+        width() * height() values to @p output.
+        The noise is taken from MNN::Random::local(). */
+    void getNoisyBackgroundImage(
+            uint32_t index, float backgroundThreshold, float minRnd, float maxRnd,
+            float* output) const;
+    void getNoisyImage(
+            uint32_t index, float minRnd, float maxRnd, float* output) const;
+    void getTransformedImage(
+            uint32_t index, float maxMorphPixels, float* output) const;
+
     // ------------- io -------------
 
     /** Throws MNN::Exception on any error */
@@ -9,6 +9,7 @@
 #define MNNSRC_ACTIVATION_H_INCLUDED
 
 #include <cmath>
+#include <algorithm>
 
 namespace MNN {
 
@@ -0,0 +1,80 @@
+/** @file allocation_counter.h
+
+    @brief Debug hook for counting heap allocations
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_ALLOCATION_COUNTER_H
+#define MNNSRC_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include "exception.h"
+
+namespace MNN {
+
+/** Number of calls to the global operator new of all threads.
+    Only counts when MNN_DEFINE_ALLOCATION_COUNTER is placed
+    in one translation unit of the program, otherwise stays 0. */
+inline std::atomic<size_t>& allocationCount()
+{
+    static std::atomic<size_t> count(0);
+    return count;
+}
+
+/** Remembers the allocationCount() on construction */
+class AllocationCheck
+{
+public:
+    AllocationCheck() : start_(allocationCount().load()) { }
+
+    /** Number of allocations since construction */
+    size_t numAllocations() const { return allocationCount().load() - start_; }
+
+    /** @throws MNN::Exception if anything was allocated since construction */
+    void check(const char* where) const
+    {
+        if (const size_t num = numAllocations())
+            MNN_EXCEPTION(num << " heap allocation(s) in " << where);
+    }
+
+private:
+    size_t start_;
+};
+
+} // namespace MNN
+
+
+#if defined(__GNUC__)
+    // keeps gcc from matching inlined malloc()/free() against new/delete
+#   define MNN_ALLOCATION_COUNTER_NOINLINE __attribute__((noinline))
+#else
+#   define MNN_ALLOCATION_COUNTER_NOINLINE
+#endif
+
+/** Replaces the global operator new and delete with versions
+    that increase MNN::allocationCount().
+    Must be placed in exactly one .cpp file, outside of any namespace. */
+#define MNN_DEFINE_ALLOCATION_COUNTER \
+    MNN_ALLOCATION_COUNTER_NOINLINE \
+    void* operator new(std::size_t size) \
+    { \
+        ++::MNN::allocationCount(); \
+        if (void* p = std::malloc(size ? size : 1)) \
+            return p; \
+        throw std::bad_alloc(); \
+    } \
+    void* operator new[](std::size_t size) { return operator new(size); } \
+    MNN_ALLOCATION_COUNTER_NOINLINE \
+    void operator delete(void* p) noexcept { std::free(p); } \
+    MNN_ALLOCATION_COUNTER_NOINLINE \
+    void operator delete[](void* p) noexcept { std::free(p); }
+
+#endif // MNNSRC_ALLOCATION_COUNTER_H
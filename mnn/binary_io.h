@@ -0,0 +1,525 @@
+/** @file binary_io.h
+
+    @brief Versioned binary model format
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_BINARY_IO_H
+#define MNNSRC_BINARY_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <utility>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "buffer.h"
+#include "mapped_file.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** Layout of the binary model format, written by BinaryWriter
+    and read by BinaryReader.
+
+    All numbers are little-endian, independent of the machine.
+
+    @li file header: magic (8 bytes), format version (u32),
+        endianness tag 0x01020304 (u32)
+    @li layer record: id (string), activation (string, empty if none),
+        layer version (u32), size of the following payload in bytes (u64),
+        payload. Stacks contain the records of their sub-layers.
+        Readers skip unknown trailing data of a record,
+        so layers can append fields in newer versions.
+    @li string: length (u32), characters
+    @li uint: u64, float: IEEE double, bool: u8
+    @li block: element size in bytes (u32), reserved (u32), count (u64),
+        zero padding up to the next multiple of blockAlignment
+        from the start of the file, raw IEEE values.
+        Blocks of float and double can be read as either type.
+*/
+namespace Binary
+{
+    /** Version of the container format */
+    static const uint32_t version = 1;
+    /** Alignment of the values of a block within the file */
+    static const size_t blockAlignment = 64;
+    static const size_t magicSize = 8;
+    /** Starts with a non-ASCII byte so it's never confused with text */
+    inline const char* magic() { return "\x89MNNBIN\n"; }
+    static const uint32_t endianTag = 0x01020304;
+
+    /** Returns true if the @p size bytes at @p data start with the magic */
+    inline bool isBinary(const char* data, size_t size)
+        { return size >= magicSize && std::memcmp(data, magic(), magicSize) == 0; }
+
+    /** Returns true if the file exists and is in the binary format */
+    inline bool isBinaryFile(const std::string& filename)
+    {
+        std::ifstream fs(filename, std::ios_base::in | std::ios_base::binary);
+        char buf[magicSize];
+        if (!fs.read(buf, magicSize))
+            return false;
+        return isBinary(buf, magicSize);
+    }
+
+    inline bool isLittleEndian()
+    {
+        const uint16_t v = 1;
+        unsigned char c;
+        std::memcpy(&c, &v, 1);
+        return c == 1;
+    }
+
+    /** Reverses the byte order of @p num elements of @p size bytes */
+    inline void swapBytes(char* data, size_t size, size_t num)
+    {
+        for (size_t i = 0; i < num; ++i, data += size)
+            for (size_t j = 0; j < size / 2; ++j)
+                std::swap(data[j], data[size - 1 - j]);
+    }
+
+} // namespace Binary
+
+
+
+/** Writes the binary model format into memory.
+
+    Layers implement Layer::serializeBinary() with
+    beginLayer(), the write functions and endLayer().
+    See Binary for the layout. */
+class BinaryWriter
+{
+public:
+
+    BinaryWriter() { }
+
+    /** The bytes written so far */
+    const std::vector<char>& data() const { return buf_; }
+    size_t size() const { return buf_.size(); }
+
+    /** Writes magic, version and endianness tag */
+    void writeHeader()
+    {
+        writeRaw_(Binary::magic(), Binary::magicSize);
+        writeLE_(Binary::version, 4);
+        writeLE_(Binary::endianTag, 4);
+    }
+
+    void writeUInt(uint64_t v) { writeLE_(v, 8); }
+    void writeBool(bool v) { const char c = v ? 1 : 0; writeRaw_(&c, 1); }
+    void writeFloat(double v)
+    {
+        uint64_t u;
+        std::memcpy(&u, &v, 8);
+        writeLE_(u, 8);
+    }
+    void writeString(const std::string& s)
+    {
+        writeLE_(s.size(), 4);
+        writeRaw_(s.data(), s.size());
+    }
+
+    /** Writes @p num values as an aligned block */
+    template <typename Float>
+    void writeBlock(const Float* data, size_t num);
+
+    /** Starts the record of a layer, must be matched by endLayer() */
+    void beginLayer(const std::string& id, const std::string& activation, uint32_t version)
+    {
+        writeString(id);
+        writeString(activation);
+        writeLE_(version, 4);
+        layerStart_.push_back(buf_.size());
+        writeLE_(0, 8);
+    }
+
+    /** Finishes the record started by the last beginLayer() */
+    void endLayer()
+    {
+        if (layerStart_.empty())
+            MNN_EXCEPTION("BinaryWriter::endLayer() without beginLayer()");
+        const size_t pos = layerStart_.back();
+        layerStart_.pop_back();
+        const uint64_t size = buf_.size() - pos - 8;
+        for (size_t i = 0; i < 8; ++i)
+            buf_[pos + i] = char((size >> (i * 8)) & 0xff);
+    }
+
+    /** Writes all data to @p out */
+    void writeTo(std::ostream& out) const
+    {
+        if (!buf_.empty())
+            out.write(&buf_[0], buf_.size());
+    }
+
+    /** Writes all data to the file @p filename.
+        @throws MNN::Exception */
+    void saveFile(const std::string& filename) const
+    {
+        std::ofstream fs(filename, std::ios_base::out | std::ios_base::binary
+                                 | std::ios_base::trunc);
+        if (!fs.is_open())
+            MNN_EXCEPTION("Could not open file for writing '" << filename << "'");
+        writeTo(fs);
+        fs.close();
+        if (fs.fail())
+            MNN_EXCEPTION("Could not write " << buf_.size() << " bytes to '"
+                          << filename << "'");
+    }
+
+private:
+
+    void writeRaw_(const char* data, size_t num) { buf_.insert(buf_.end(), data, data + num); }
+
+    void writeLE_(uint64_t v, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+            buf_.push_back(char((v >> (i * 8)) & 0xff));
+    }
+
+    std::vector<char> buf_;
+    std::vector<size_t> layerStart_;
+};
+
+
+
+/** Reads the binary model format from memory.
+
+    The reader either views external memory, holds the contents
+    of a file read with readFile() or maps a file with mapFile().
+    All read functions throw a MNN::Exception on truncated
+    or malformed data.
+
+    Of a mapped file, readBlock(Buffer&) lets the Buffer view the
+    values in place when they are stored in the machine's format.
+    The mapping is kept alive by these Buffers, so any number of
+    processes loading the same model share one copy
+    of the parameters in the page cache. */
+class BinaryReader
+{
+    BinaryReader(const BinaryReader&) = delete;
+    void operator = (const BinaryReader&) = delete;
+
+public:
+
+    /** Header of a layer record */
+    struct LayerHeader
+    {
+        std::string id, activation;
+        uint32_t version;
+        /** Payload size in bytes */
+        uint64_t size;
+    };
+
+    BinaryReader() : data_(nullptr), size_(0), pos_(0) { }
+
+    /** Reads from @p size bytes at @p data, which must stay valid */
+    BinaryReader(const char* data, size_t size) : data_(data), size_(size), pos_(0) { }
+
+    /** Reads the whole file into memory
+        @throws MNN::Exception */
+    void readFile(const std::string& filename)
+    {
+        std::ifstream fs(filename, std::ios_base::in | std::ios_base::binary);
+        if (!fs.is_open())
+            MNN_EXCEPTION("Could not open file for reading '" << filename << "'");
+        fs.seekg(0, std::ios_base::end);
+        const std::streamoff len = fs.tellg();
+        fs.seekg(0, std::ios_base::beg);
+        if (len < 0)
+            MNN_EXCEPTION("Could not determine size of '" << filename << "'");
+        mem_.resize(size_t(len));
+        if (len > 0 && !fs.read(&mem_[0], len))
+            MNN_EXCEPTION("Could not read " << len << " bytes from '" << filename << "'");
+        setData_(mem_.empty() ? nullptr : &mem_[0], mem_.size());
+    }
+
+    /** Maps the file read-only
+        @throws MNN::Exception, also if memory-mapping is not supported */
+    void mapFile(const std::string& filename)
+    {
+        auto file = std::make_shared<MappedFile>();
+        file->open(filename);
+        std::vector<char>().swap(mem_);
+        const MappedFile& cfile = *file;
+        setData_(cfile.data(), cfile.size());
+        file_ = file;
+    }
+
+    /** Reads the @p size bytes at position @p pos of @p src,
+        e.g. one layer record, sharing the memory or mapping of @p src,
+        which must stay alive while reading.
+        Positions stay those of @p src, so the alignment of blocks
+        is unchanged. Used to read records concurrently. */
+    void viewRange(const BinaryReader& src, size_t pos, size_t size)
+    {
+        if (pos > src.size_ || size > src.size_ - pos)
+            MNN_EXCEPTION("Range exceeds binary model");
+        setData_(src.data_, pos + size);
+        pos_ = pos;
+        file_ = src.file_;
+    }
+
+    /** Reads the rest of the stream @p in into memory */
+    void readStream(std::istream& in)
+    {
+        mem_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        setData_(mem_.empty() ? nullptr : &mem_[0], mem_.size());
+    }
+
+    // ------------ getter ---------------
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t position() const { return pos_; }
+    bool atEnd() const { return pos_ >= size_; }
+    /** True if reading from a file opened with mapFile() */
+    bool isMapped() const { return file_ != nullptr; }
+
+    // ------------ reading --------------
+
+    /** Reads and checks magic, version and endianness tag */
+    void readHeader()
+    {
+        if (!Binary::isBinary(data_, size_))
+            MNN_EXCEPTION("Binary model header not found");
+        pos_ = Binary::magicSize;
+        const uint32_t ver = uint32_t(readLE_(4));
+        if (ver > Binary::version)
+            MNN_EXCEPTION("Binary model format version " << ver << " is not supported");
+        const uint32_t tag = uint32_t(readLE_(4));
+        if (tag != Binary::endianTag)
+            MNN_EXCEPTION("Unknown endianness tag 0x" << std::hex << tag << std::dec
+                          << " in binary model");
+    }
+
+    uint64_t readUInt() { return readLE_(8); }
+    bool readBool() { need_(1); return data_[pos_++] != 0; }
+    double readFloat()
+    {
+        const uint64_t u = readLE_(8);
+        double v;
+        std::memcpy(&v, &u, 8);
+        return v;
+    }
+    std::string readString()
+    {
+        const size_t len = size_t(readLE_(4));
+        need_(len);
+        std::string s(data_ + pos_, len);
+        pos_ += len;
+        return s;
+    }
+
+    /** Reads a block of exactly @p num values into @p dst,
+        converting between float and double if needed */
+    template <typename Float>
+    void readBlock(Float* dst, size_t num);
+
+    /** Reads a block of exactly @p num values into @p dst,
+        which is resized to @p num.
+        If the file is mapped and stores the values in the
+        machine's format, @p dst becomes a read-only view
+        into the mapping, see Buffer::setConstView(),
+        without allocating memory. */
+    template <typename Float>
+    void readBlock(Buffer<Float>& dst, size_t num);
+
+    /** Reads the next layer header without moving on */
+    LayerHeader peekLayer()
+    {
+        const size_t pos = pos_;
+        LayerHeader h = readLayerHeader_();
+        pos_ = pos;
+        return h;
+    }
+
+    /** Starts reading the record of the layer @p id.
+        Returns the layer version. Must be matched by endLayer() */
+    uint32_t beginLayer(const std::string& id)
+    {
+        const LayerHeader h = readLayerHeader_();
+        if (h.id != id)
+            MNN_EXCEPTION("Expected '" << id << "' in binary model, found '"
+                          << h.id << "'");
+        need_(size_t(h.size));
+        layerEnd_.push_back(pos_ + size_t(h.size));
+        return h.version;
+    }
+
+    /** Moves to the end of the record started by the last beginLayer() */
+    void endLayer()
+    {
+        if (layerEnd_.empty())
+            MNN_EXCEPTION("BinaryReader::endLayer() without beginLayer()");
+        const size_t end = layerEnd_.back();
+        layerEnd_.pop_back();
+        if (pos_ > end)
+            MNN_EXCEPTION("Layer record in binary model is " << (pos_ - end)
+                          << " bytes too short");
+        pos_ = end;
+    }
+
+    /** Skips the next layer record */
+    void skipLayer()
+    {
+        const LayerHeader h = readLayerHeader_();
+        need_(size_t(h.size));
+        pos_ += size_t(h.size);
+    }
+
+private:
+
+    void setData_(const char* data, size_t size)
+        { data_ = data; size_ = size; pos_ = 0; layerEnd_.clear(); file_.reset(); }
+
+    /** Reads a block header for @p num values and returns the start of
+        the values. @p elSize is set to the stored size of one value */
+    const char* readBlockData_(size_t num, size_t& elSize);
+
+    void need_(size_t num) const
+    {
+        const size_t end = layerEnd_.empty() ? size_ : layerEnd_.back();
+        if (num > end || pos_ > end - num)
+            MNN_EXCEPTION("Unexpected end of binary model at byte " << pos_);
+    }
+
+    uint64_t readLE_(size_t bytes)
+    {
+        need_(bytes);
+        uint64_t v = 0;
+        for (size_t i = 0; i < bytes; ++i)
+            v |= uint64_t((unsigned char)data_[pos_ + i]) << (i * 8);
+        pos_ += bytes;
+        return v;
+    }
+
+    LayerHeader readLayerHeader_()
+    {
+        LayerHeader h;
+        h.id = readString();
+        h.activation = readString();
+        h.version = uint32_t(readLE_(4));
+        h.size = readLE_(8);
+        return h;
+    }
+
+    const char* data_;
+    size_t size_, pos_;
+    std::vector<size_t> layerEnd_;
+    std::vector<char> mem_;
+    std::shared_ptr<MappedFile> file_;
+};
+
+
+
+// ------------------ impl ------------------
+
+template <typename Float>
+void BinaryWriter::writeBlock(const Float* data, size_t num)
+{
+    writeLE_(sizeof(Float), 4);
+    writeLE_(0, 4);
+    writeLE_(num, 8);
+    buf_.resize((buf_.size() + Binary::blockAlignment - 1)
+                / Binary::blockAlignment * Binary::blockAlignment, 0);
+    const size_t pos = buf_.size();
+    writeRaw_(reinterpret_cast<const char*>(data), num * sizeof(Float));
+    if (!Binary::isLittleEndian() && num)
+        Binary::swapBytes(&buf_[pos], sizeof(Float), num);
+}
+
+inline const char* BinaryReader::readBlockData_(size_t num, size_t& elSize)
+{
+    elSize = size_t(readLE_(4));
+    readLE_(4);
+    const uint64_t count = readLE_(8);
+    if (count != num)
+        MNN_EXCEPTION("Expected block of " << num << " values in binary model, found "
+                      << count);
+    if (elSize != sizeof(float) && elSize != sizeof(double))
+        MNN_EXCEPTION("Unsupported value size " << elSize << " in binary model");
+
+    const size_t start = (pos_ + Binary::blockAlignment - 1)
+                        / Binary::blockAlignment * Binary::blockAlignment;
+    need_(start - pos_);
+    pos_ = start;
+    if (num > (size_t(-1) / elSize))
+        MNN_EXCEPTION("Block size overflow in binary model");
+    need_(num * elSize);
+    const char* src = data_ + pos_;
+    pos_ += num * elSize;
+    return src;
+}
+
+template <typename Float>
+void BinaryReader::readBlock(Buffer<Float>& dst, size_t num)
+{
+    if (file_ && Binary::isLittleEndian())
+    {
+        const size_t pos = pos_;
+        size_t elSize;
+        const char* src = readBlockData_(num, elSize);
+        if (elSize == sizeof(Float)
+            && reinterpret_cast<uintptr_t>(src) % alignof(Float) == 0)
+        {
+            dst.setConstView(reinterpret_cast<const Float*>(src), num, file_);
+            return;
+        }
+        pos_ = pos;
+    }
+    dst.resize(num);
+    readBlock(dst.data(), num);
+}
+
+template <typename Float>
+void BinaryReader::readBlock(Float* dst, size_t num)
+{
+    size_t elSize;
+    const char* src = readBlockData_(num, elSize);
+    if (num == 0)
+        return;
+
+    if (elSize == sizeof(Float))
+    {
+        std::memcpy(dst, src, num * sizeof(Float));
+        if (!Binary::isLittleEndian())
+            Binary::swapBytes(reinterpret_cast<char*>(dst), sizeof(Float), num);
+        return;
+    }
+
+    // convert between float and double
+    char tmp[sizeof(double)];
+    for (size_t i = 0; i < num; ++i, src += elSize)
+    {
+        std::memcpy(tmp, src, elSize);
+        if (!Binary::isLittleEndian())
+            Binary::swapBytes(tmp, elSize, 1);
+        if (elSize == sizeof(float))
+        {
+            float f;
+            std::memcpy(&f, tmp, sizeof(float));
+            dst[i] = Float(f);
+        }
+        else
+        {
+            double d;
+            std::memcpy(&d, tmp, sizeof(double));
+            dst[i] = Float(d);
+        }
+    }
+}
+
+} // namespace MNN
+
+#endif // MNNSRC_BINARY_IO_H
@@ -0,0 +1,232 @@
+/** @file buffer.h
+
+    @brief Float array that can live in external memory
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_BUFFER_H
+#define MNNSRC_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+namespace MNN {
+
+/** A resizable array of Floats, used for layer parameters.
+
+    Behaves like a (minimal) std::vector, but the values can be moved
+    into memory owned by someone else with setView(), e.g. a
+    ParameterArena. The external memory is kept alive by a shared owner
+    pointer, so a view never dangles.
+
+    Copies are implicitly shared (copy-on-write): copying a Buffer only
+    increases a reference count and the values are cloned on the first
+    non-const access of either side. A copy of a whole network, e.g.
+    Layer::getCopy(), is therefore cheap and only the layers that are
+    subsequently written to pay for their memory.
+    Read-only code should use constData() to not trigger the clone.
+
+    Like any other Buffer method, copying must be synchronized with
+    writes to the same Buffer. Copies can then be read in other threads
+    while the original is changed.
+    Each non-const accessor checks the reference count, so hot loops
+    should take the pointer once.
+
+    Assignment from an array of the same size to a view copies the values
+    in place and keeps the view. Any change of the size moves the values
+    back into the Buffer's own memory. Copies of views are never views.
+
+    A read-only view, see setConstView(), e.g. of a memory-mapped model
+    file, is shared by copies and moved into own memory on the
+    first write access.
+*/
+template <typename Float>
+class Buffer
+{
+public:
+
+    typedef Float value_type;
+    typedef Float* iterator;
+    typedef const Float* const_iterator;
+
+    Buffer() : data_(nullptr), size_(0), readOnly_(false) { }
+
+    explicit Buffer(size_t size, Float value = Float(0))
+        : data_(nullptr), size_(0), readOnly_(false)
+    {
+        if (size)
+            setMemory_(std::make_shared<std::vector<Float>>(size, value));
+    }
+
+    /** Shares the memory of @p other, or copies it if @p other is a view */
+    Buffer(const Buffer& other) : data_(nullptr), size_(0), readOnly_(false) { share_(other); }
+
+    Buffer& operator = (const Buffer& other)
+    {
+        if (this == &other)
+            return *this;
+        if (isView() && !readOnly_ && size_ == other.size_)
+            std::copy(other.begin(), other.end(), data_);
+        else
+        {
+            owner_.reset();
+            share_(other);
+        }
+        return *this;
+    }
+
+    Buffer& operator = (const std::vector<Float>& other)
+    {
+        resize(other.size());
+        std::copy(other.begin(), other.end(), data());
+        return *this;
+    }
+
+    // ------------ getter -------------------
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /** Returns true when the values live in external memory */
+    bool isView() const { return owner_ != nullptr; }
+
+    /** Returns true when the values live in external read-only memory */
+    bool isReadOnly() const { return readOnly_; }
+
+    /** Returns true when the memory is shared with a copy */
+    bool isShared() const { return mem_ && mem_.use_count() > 1; }
+
+    /** Read access that never clones shared memory */
+    const Float* constData() const { return data_; }
+
+    const Float* data() const { return data_; }
+    const Float& operator[](size_t index) const { return data_[index]; }
+    const Float* begin() const { return data_; }
+    const Float* end() const { return data_ + size_; }
+
+    // ------------ write access -------------
+
+    /** Write access, clones the memory if it is shared or read-only */
+    Float* data() { detachShared_(); return data_; }
+
+    Float& operator[](size_t index) { detachShared_(); return data_[index]; }
+    Float* begin() { detachShared_(); return data_; }
+    Float* end() { detachShared_(); return data_ + size_; }
+
+    // ------------ setter -------------------
+
+    /** Changes the size, new values are zero.
+        A view is detached if the size changes. */
+    void resize(size_t size)
+    {
+        if (size == size_)
+            return;
+        if (isView() || isShared())
+        {
+            auto mem = std::make_shared<std::vector<Float>>(
+                        data_, data_ + std::min(size, size_));
+            mem->resize(size);
+            owner_.reset();
+            readOnly_ = false;
+            setMemory_(mem);
+            return;
+        }
+        if (!mem_)
+            mem_ = std::make_shared<std::vector<Float>>();
+        mem_->resize(size);
+        data_ = mem_->data();
+        size_ = size;
+    }
+
+    /** Copies the values to @p data and uses it from now on.
+        @p data must hold size() Floats and stay valid as long as
+        @p owner is referenced. */
+    void setView(Float* data, std::shared_ptr<void> owner)
+    {
+        std::copy(data_, data_ + size_, data);
+        data_ = data;
+        owner_ = owner;
+        mem_.reset();
+        readOnly_ = false;
+    }
+
+    /** Uses the @p size Floats at @p data without copying.
+        The memory is never written to and must stay valid as long as
+        @p owner is referenced. */
+    void setConstView(const Float* data, size_t size, std::shared_ptr<void> owner)
+    {
+        mem_.reset();
+        data_ = const_cast<Float*>(data);
+        size_ = size;
+        owner_ = owner;
+        readOnly_ = true;
+    }
+
+    /** Moves the values back into own memory */
+    void detach()
+    {
+        if (!isView())
+            return;
+        setMemory_(std::make_shared<std::vector<Float>>(data_, data_ + size_));
+        owner_.reset();
+        readOnly_ = false;
+    }
+
+private:
+
+    void setMemory_(const std::shared_ptr<std::vector<Float>>& mem)
+    {
+        mem_ = mem;
+        data_ = mem_->data();
+        size_ = mem_->size();
+    }
+
+    void share_(const Buffer& other)
+    {
+        readOnly_ = false;
+        if (other.readOnly_)
+        {
+            mem_.reset();
+            data_ = other.data_;
+            size_ = other.size_;
+            owner_ = other.owner_;
+            readOnly_ = true;
+        }
+        else if (other.isView())
+            setMemory_(std::make_shared<std::vector<Float>>(other.begin(), other.end()));
+        else if (other.mem_)
+            setMemory_(other.mem_);
+        else
+        {
+            mem_.reset();
+            data_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    void detachShared_()
+    {
+        if ((mem_ && mem_.use_count() > 1) || readOnly_)
+        {
+            setMemory_(std::make_shared<std::vector<Float>>(data_, data_ + size_));
+            owner_.reset();
+            readOnly_ = false;
+        }
+    }
+
+    std::shared_ptr<std::vector<Float>> mem_;
+    Float* data_;
+    size_t size_;
+    std::shared_ptr<void> owner_;
+    bool readOnly_;
+};
+
+} // namespace MNN
+
+#endif // MNNSRC_BUFFER_H
@@ -0,0 +1,148 @@
+/** @file checkpointer.h
+
+    @brief Asynchronous saving of layer snapshots
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_CHECKPOINTER_H
+#define MNNSRC_CHECKPOINTER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <utility>
+
+#include "layer.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** Saves checkpoints of a network without stalling training.
+
+    save() takes a snapshot of the layer with Layer::getCopy(),
+    which shares the parameters copy-on-write, and returns.
+    A background thread writes the snapshot to a temporary file
+    and renames it to the final filename, so a checkpoint on disk
+    is always complete, even if the process is killed while writing.
+
+    If the writer falls behind, a waiting snapshot for the same
+    filename is replaced by the newer one.
+    With setKeepLast() only the most recently written files
+    are kept and older checkpoints are deleted.
+
+    @code
+    Checkpointer<float> cp;
+    cp.setKeepLast(3);
+    while (training)
+    {
+        net.bprop(...);
+        if (better)
+            cp.save(net, "net_e" + std::to_string(errors) + ".txt");
+    }
+    cp.wait();
+    @endcode
+
+    save() must be synchronized with changes to the layer,
+    typically by calling it from the training thread.
+    Written snapshots are released by the next save() or wait(),
+    so that the training thread, which decides about copy-on-write
+    by the reference count of the parameters, also drops the
+    last reference of a snapshot.
+*/
+template <typename Float>
+class Checkpointer
+{
+    Checkpointer(const Checkpointer&) = delete;
+    void operator = (const Checkpointer&) = delete;
+
+public:
+
+    enum Format
+    {
+        /** Layer::saveTextFile() */
+        F_TEXT,
+        /** Layer::saveBinaryFile() */
+        F_BINARY
+    };
+
+    Checkpointer();
+    /** Writes all pending snapshots. Errors are ignored. */
+    ~Checkpointer();
+
+    // ------------ settings -------------
+
+    /** Format of the following save() calls, default is F_TEXT */
+    void setFormat(Format f) { format_ = f; }
+    /** Number of written files to keep, 0 = all (default) */
+    void setKeepLast(size_t num);
+
+    // ------------ getter ---------------
+
+    Format format() const { return format_; }
+    size_t keepLast() const { return keepLast_; }
+
+    /** Number of snapshots not yet written */
+    size_t numPending() const;
+
+    /** Number of files written so far */
+    size_t numWritten() const { return numWritten_.load(); }
+
+    /** The kept files, oldest first */
+    std::deque<std::string> files() const;
+
+    // ------------ saving ---------------
+
+    /** Takes a snapshot of @p layer and writes it
+        to @p filename in the background. */
+    void save(const Layer<Float>& layer, const std::string& filename);
+
+    /** Blocks until all snapshots are written.
+        Rethrows the first error of the writer since the last call. */
+    void wait();
+
+private:
+
+    struct Job
+    {
+        std::shared_ptr<const Layer<Float>> layer;
+        std::string filename;
+        Format format;
+    };
+
+    void work_();
+    static void write_(const Job& job);
+    /** Adds @p filename to the kept files and deletes the oldest */
+    void keep_(const std::string& filename);
+
+    Format format_;
+    size_t keepLast_;
+
+    std::deque<Job> queue_;
+    /** Written snapshots, released by the saving thread */
+    std::vector<std::shared_ptr<const Layer<Float>>> done_;
+    std::deque<std::string> files_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_, doneCond_;
+    bool stop_, busy_;
+    std::exception_ptr error_;
+    std::atomic<size_t> numWritten_;
+};
+
+#include "checkpointer_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_CHECKPOINTER_H
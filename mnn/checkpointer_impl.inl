@@ -0,0 +1,184 @@
+/** @file checkpointer_impl.inl
+
+    @brief Checkpointer implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_CHECKPOINTER Checkpointer<Float>
+
+MNN_TEMPLATE
+MNN_CHECKPOINTER::Checkpointer()
+    : format_       (F_TEXT)
+    , keepLast_     (0)
+    , stop_         (false)
+    , busy_         (false)
+    , numWritten_   (0)
+{
+}
+
+MNN_TEMPLATE
+MNN_CHECKPOINTER::~Checkpointer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::setKeepLast(size_t num)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    keepLast_ = num;
+}
+
+MNN_TEMPLATE
+size_t MNN_CHECKPOINTER::numPending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + (busy_ ? 1 : 0);
+}
+
+MNN_TEMPLATE
+std::deque<std::string> MNN_CHECKPOINTER::files() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return files_;
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::save(const Layer<Float>& layer, const std::string& filename)
+{
+    // the only work on the calling thread
+    Job job;
+    job.layer.reset(layer.getCopy());
+    job.filename = filename;
+    job.format = format_;
+
+    std::vector<std::shared_ptr<const Layer<Float>>> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(done_);
+
+        // replace a waiting snapshot of the same file
+        bool replaced = false;
+        for (auto& j : queue_)
+            if (j.filename == filename)
+            {
+                std::swap(j, job);
+                replaced = true;
+                break;
+            }
+        if (!replaced)
+            queue_.push_back(std::move(job));
+
+        if (!thread_.joinable())
+            thread_ = std::thread([this](){ work_(); });
+    }
+    cond_.notify_one();
+    // release the written and replaced snapshots here, not under the lock
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::wait()
+{
+    std::vector<std::shared_ptr<const Layer<Float>>> done;
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doneCond_.wait(lock, [this](){ return queue_.empty() && !busy_; });
+        done.swap(done_);
+        error = error_;
+        error_ = nullptr;
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::work_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        cond_.wait(lock, [this](){ return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+            break;
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        bool ok = true;
+        try
+        {
+            write_(job);
+            ++numWritten_;
+        }
+        catch (...)
+        {
+            ok = false;
+            lock.lock();
+            if (!error_)
+                error_ = std::current_exception();
+            lock.unlock();
+        }
+        lock.lock();
+        done_.push_back(std::move(job.layer));
+        if (ok)
+            keep_(job.filename);
+        busy_ = false;
+        doneCond_.notify_all();
+    }
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::write_(const Job& job)
+{
+    const std::string tmp = job.filename + ".tmp";
+    if (job.format == F_BINARY)
+        job.layer->saveBinaryFile(tmp);
+    else
+        job.layer->saveTextFile(tmp);
+
+    if (std::rename(tmp.c_str(), job.filename.c_str()) != 0)
+    {
+        // rename() does not replace existing files on every system
+        std::remove(job.filename.c_str());
+        if (std::rename(tmp.c_str(), job.filename.c_str()) != 0)
+        {
+            std::remove(tmp.c_str());
+            MNN_EXCEPTION("Could not rename '" << tmp << "' to '" << job.filename << "'");
+        }
+    }
+}
+
+MNN_TEMPLATE
+void MNN_CHECKPOINTER::keep_(const std::string& filename)
+{
+    for (auto i = files_.begin(); i != files_.end(); ++i)
+        if (*i == filename)
+        {
+            files_.erase(i);
+            break;
+        }
+    files_.push_back(filename);
+
+    while (keepLast_ && files_.size() > keepLast_)
+    {
+        std::remove(files_.front().c_str());
+        files_.pop_front();
+    }
+}
+
+#undef MNN_TEMPLATE
+#undef MNN_CHECKPOINTER
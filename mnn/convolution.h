@@ -14,10 +14,12 @@
 #include <cmath>
 #include <cassert>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 #include "layer.h"
 #include "interface.h"
+#include "optimizer.h"
 
 namespace MNN {
 
@@ -40,6 +42,8 @@ class Convolution
         : public Layer<Float>
         , public GetMomentumInterface<Float>
         , public SetMomentumInterface<Float>
+        , public GetOptimizerInterface<Float>
+        , public SetOptimizerInterface<Float>
         , public SetLearnRateInterface<Float>
         , public GetLearnRateInterface<Float>
         , public SetLearnRateBiasInterface<Float>
@@ -75,8 +79,13 @@ class Convolution
 
     // --------- MomentumInterface -----------
 
-    virtual Float momentum() const override { return momentum_; }
-    virtual void setMomentum(Float m) override { momentum_ = m; }
+    virtual Float momentum() const override { return optimizer_->momentum(); }
+    virtual void setMomentum(Float m) override { optimizer_->setMomentum(m); }
+
+    // --------- OptimizerInterface ----------
+
+    virtual const Optimizer<Float>& optimizer() const override { return *optimizer_; }
+    virtual void setOptimizer(const Optimizer<Float>& opt) override;
 
     // --------- LearnRateInterface ----------
 
@@ -128,6 +137,14 @@ class Convolution
     virtual const Float* outputs() const override { return &output_[0]; }
     virtual const Float* weights() const override { return &weight_[0]; }
     virtual Float* weights() override { return &weight_[0]; }
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>&) override;
+    virtual bool setInputStorage(Float* data, const std::shared_ptr<void>& owner) override
+        { input_.setView(data, owner); return true; }
+    virtual bool setOutputStorage(Float* data, const std::shared_ptr<void>& owner) override
+        { output_.setView(data, owner); return true; }
+    virtual void detachStorage() override { input_.detach(); output_.detach(); }
+    virtual void setLean(bool lean) override { optimizer_->setLean(lean); }
+    virtual void releaseTrainingState() override { optimizer_->releaseState(); }
 
     virtual Float weight(size_t input, size_t output) const override
         { assert(!"Can't use this function in Convolution"); (void)input; (void)output; }
@@ -137,6 +154,8 @@ class Convolution
     // ------- propagation -------------------
 
     virtual void fprop(const Float * input, Float * output) override;
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const override;
 
     virtual void bprop(const Float * error, Float * error_output = 0,
                        Float global_learn_rate = 1) override;
@@ -147,6 +166,7 @@ class Convolution
     virtual const char * id() const override { return static_id(); }
     virtual const char * name() const override { return "Convolution"; }
     virtual size_t numParameters() const override { return weight_.size() + bias_.size(); }
+    virtual void getMemoryUsage(MemoryUsage&) const override;
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const override;
     virtual void dump(std::ostream &out = std::cout) const override;
@@ -157,18 +177,32 @@ class Convolution
 
     virtual void serialize(std::ostream&) const override;
     virtual void deserialize(std::istream&) override;
+    virtual void serializeBinary(BinaryWriter&) const override;
+    virtual void deserializeBinary(BinaryReader&) override;
 
 protected:
 
-    std::vector<Float>
+    /** Sizes the scratch buffers for the current dimensions,
+        so that propagation does not need to allocate */
+    void resizeScratch_();
+
+    /** May live in the memory of a StackSerial,
+        see setInputStorage() */
+    Buffer<Float>
         input_,
-        output_,
-        weight_,
-        bias_,
+        output_;
+
+    std::vector<Float>
         outputErr_,
-        prevDelta_,
         weightBuffer_;
 
+    /** Trainable parameters */
+    Buffer<Float>
+        weight_,
+        bias_;
+
+    std::unique_ptr<Optimizer<Float>> optimizer_;
+
     size_t
         inputMaps_, parallelMaps_,
         inputWidth_, inputHeight_,
@@ -177,8 +211,7 @@ protected:
         strideX_, strideY_;
     Float
         learnRate_,
-        learnRateBias_,
-        momentum_;
+        learnRateBias_;
 
     bool doBias_;
 };
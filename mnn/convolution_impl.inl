@@ -30,9 +30,9 @@ MNN_CONVOLUTION::Convolution(size_t inputWidth, size_t inputHeight, size_t input
                              size_t strideX, size_t strideY,
                              size_t kernelWidth, size_t kernelHeight, size_t outputMaps,
                              Float learnRate)
-    : learnRate_	(learnRate)
+    : optimizer_    (new OptimizerSgd<Float>())
+    , learnRate_	(learnRate)
     , learnRateBias_(.1)
-    , momentum_     (.1)
     , doBias_       (true)
 {
     resize(inputWidth, inputHeight, inputMaps,
@@ -73,7 +73,8 @@ Convolution<Float, ActFunc>& MNN_CONVOLUTION::operator = (const Layer<Float>& la
     output_ = net->output_;
     bias_ = net->bias_;
     weight_ = net->weight_;
-    prevDelta_ = net->prevDelta_;
+    if (!optimizer_->assign(*net->optimizer_))
+        optimizer_.reset(net->optimizer_->getCopy());
 
     inputWidth_ = net->inputWidth_;
     inputHeight_ = net->inputHeight_;
@@ -87,7 +88,10 @@ Convolution<Float, ActFunc>& MNN_CONVOLUTION::operator = (const Layer<Float>& la
     parallelMaps_ = net->parallelMaps_;
 
     learnRate_ = net->learnRate_;
-    momentum_ = net->momentum_;
+    learnRateBias_ = net->learnRateBias_;
+    doBias_ = net->doBias_;
+
+    resizeScratch_();
 
     return *this;
 }
@@ -101,9 +105,9 @@ void MNN_CONVOLUTION::serialize(std::ostream& s) const
     // activation
     s << " " << ActFunc::static_name();
     // version
-    s << " " << 1;
+    s << " " << 2;
     // settings
-    s << " " << learnRate_ << " " << momentum_ << " " << doBias_;
+    s << " " << learnRate_ << " " << momentum() << " " << doBias_;
     // dimension
     s << " " << inputWidth_ << " " << inputHeight_
       << " " << kernelWidth_ << " " << kernelHeight_
@@ -118,6 +122,9 @@ void MNN_CONVOLUTION::serialize(std::ostream& s) const
     // weights
     for (auto w : weight_)
         s << " " << w;
+    // optimizer (v2)
+    s << "\n";
+    optimizer_->serialize(s);
 }
 
 MNN_TEMPLATE
@@ -133,22 +140,87 @@ void MNN_CONVOLUTION::deserialize(std::istream& s)
     // version
     int ver;
     s >> ver;
-    if (ver > 1)
+    if (ver > 2)
         MNN_EXCEPTION("Wrong version in " << name());
 
     // settings
-    s >> learnRate_ >> momentum_ >> doBias_;
+    Float mom;
+    s >> learnRate_ >> mom >> doBias_;
     // dimension
     size_t iw, ih, kw, kh, im, pm, sx, sy;
     s >> iw >> ih >> kw >> kh >> sx >> sy >> im >> pm;
     resize(iw, ih, im, sx, sy, kw, kh, pm);
     // biases
     if (doBias_)
-        for (auto& b : bias_)
-            s >> b;
+        Text::readValues(s, bias_.data(), bias_.size());
     // weights
-    for (auto& w : weight_)
-        s >> w;
+    Text::readValues(s, weight_.data(), weight_.size());
+    // optimizer
+    if (ver >= 2)
+    {
+        optimizer_.reset(Optimizer<Float>::createFromStream(s));
+        if (optimizer_->numParameters() != weight_.size())
+            MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                          << " does not match " << weight_.size() << " weights in " << name());
+    }
+    else
+    {
+        optimizer_->setMomentum(mom);
+        optimizer_->reset();
+    }
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::serializeBinary(BinaryWriter& w) const
+{
+    w.beginLayer(id(), ActFunc::static_name(), 1);
+    // settings
+    w.writeFloat(learnRate_);
+    w.writeBool(doBias_);
+    // dimension
+    w.writeUInt(inputWidth_);
+    w.writeUInt(inputHeight_);
+    w.writeUInt(kernelWidth_);
+    w.writeUInt(kernelHeight_);
+    w.writeUInt(strideX_);
+    w.writeUInt(strideY_);
+    w.writeUInt(inputMaps_);
+    w.writeUInt(parallelMaps_);
+    // parameters
+    if (doBias_)
+        w.writeBlock(bias_.constData(), bias_.size());
+    w.writeBlock(weight_.constData(), weight_.size());
+    optimizer_->serializeBinary(w);
+    w.endLayer();
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::deserializeBinary(BinaryReader& r)
+{
+    const uint32_t ver = r.beginLayer(id());
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in " << name());
+
+    // settings
+    learnRate_ = Float(r.readFloat());
+    doBias_ = r.readBool();
+    // dimension
+    size_t dim[8];
+    for (auto& d : dim)
+        d = size_t(r.readUInt());
+    const size_t iw = dim[0], ih = dim[1], kw = dim[2], kh = dim[3],
+                 sx = dim[4], sy = dim[5], im = dim[6], pm = dim[7];
+    resize(iw, ih, im, sx, sy, kw, kh, pm);
+    // parameters
+    if (doBias_)
+        r.readBlock(bias_, bias_.size());
+    r.readBlock(weight_, weight_.size());
+    // optimizer
+    optimizer_.reset(Optimizer<Float>::createFromBinary(r));
+    if (optimizer_->numParameters() != weight_.size())
+        MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                      << " does not match " << weight_.size() << " weights in " << name());
+    r.endLayer();
 }
 
 
@@ -177,7 +249,34 @@ void MNN_CONVOLUTION::resize(size_t inputWidth, size_t inputHeight, size_t input
     output_.resize(scanWidth_ * scanHeight_ * parallelMaps_ * inputMaps_);
     bias_.resize(output_.size());
     weight_.resize(kernelWidth * kernelHeight * parallelMaps_ * inputMaps_);
-    prevDelta_.resize(weight_.size());
+    optimizer_->resize(weight_.size());
+    resizeScratch_();
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::resizeScratch_()
+{
+    outputErr_.resize(output_.size());
+    weightBuffer_.resize(kernelWidth_ * kernelHeight_);
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::setOptimizer(const Optimizer<Float>& opt)
+{
+    const bool lean = optimizer_->isLean();
+    optimizer_.reset(opt.getCopy());
+    if (lean)
+        optimizer_->setLean(true);
+    optimizer_->resize(weight_.size());
+    optimizer_->reset();
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    blocks.push_back({ weight_.data(), weight_.size(), PT_PARAMETER, &weight_ });
+    blocks.push_back({ bias_.data(), bias_.size(), PT_PARAMETER, &bias_ });
+    optimizer_->getParameterBlocks(blocks);
 }
 /*
 MNN_TEMPLATE
@@ -198,21 +297,18 @@ void MNN_CONVOLUTION::brainwash(Float amp)
     for (auto& e : output_)
         e = 0.0;
     // reset momentum
-    for (auto& m : prevDelta_)
-        m = 0.;
+    optimizer_->reset();
 
     if (kernelWidth_ == 0 || kernelHeight_ == 0)
         return;
 
     // randomize weights
     Float f = amp / (kernelWidth_ * kernelHeight_);
-    for (auto& w : weight_)
-        w = rnd(-f, f);
+    Random::local().fillUniform(weight_.data(), weight_.size(), -f, f);
 
     // randomize biases
     f = amp / output_.size();
-    for (auto& b : bias_)
-        b = rnd(-f, f);
+    Random::local().fillUniform(bias_.data(), bias_.size(), -f, f);
 }
 
 
@@ -222,8 +318,10 @@ MNN_TEMPLATE
 void MNN_CONVOLUTION::fprop(const Float * input, Float * output)
 {
     // copy to internal data
-    for (size_t i=0; i<input_.size(); ++i, ++input)
-        input_[i] = *input;
+    // (unless it's the storage given by setInputStorage())
+    if (input != input_.data())
+        for (size_t i=0; i<input_.size(); ++i, ++input)
+            input_[i] = *input;
 
     const size_t
             mapSizeInput = inputWidth_ * inputHeight_,
@@ -238,9 +336,9 @@ void MNN_CONVOLUTION::fprop(const Float * input, Float * output)
         if (doBias_)
             ConvolutionMatrix::fprop_bias<Float, ActFunc>(
                     &input_[im * mapSizeInput],
-                    &bias_[idx * mapSizeOutput],
+                    bias_.constData() + idx * mapSizeOutput,
                     &output_[idx * mapSizeOutput],
-                    &weight_[idx * mapSizeWeight],
+                    weight_.constData() + idx * mapSizeWeight,
                     inputWidth_, inputHeight_,
                     kernelWidth_, kernelHeight_,
                     strideX_, strideY_);
@@ -248,14 +346,49 @@ void MNN_CONVOLUTION::fprop(const Float * input, Float * output)
             ConvolutionMatrix::fprop<Float, ActFunc>(
                     &input_[im * mapSizeInput],
                     &output_[idx * mapSizeOutput],
-                    &weight_[idx * mapSizeWeight],
+                    weight_.constData() + idx * mapSizeWeight,
                     inputWidth_, inputHeight_,
                     kernelWidth_, kernelHeight_,
                     strideX_, strideY_);
     }
 
     // copy to caller
-    std::copy(output_.begin(), output_.end(), output);
+    if (output != output_.data())
+        std::copy(output_.begin(), output_.end(), output);
+}
+
+MNN_TEMPLATE
+void MNN_CONVOLUTION::infer(const Float * input, Float * output,
+                            Workspace<Float>&) const
+{
+    const size_t
+            mapSizeInput = inputWidth_ * inputHeight_,
+            mapSizeWeight = kernelWidth_ * kernelHeight_,
+            mapSizeOutput = scanWidth_ * scanHeight_;
+
+    for (size_t om = 0; om < parallelMaps_; ++om)
+    for (size_t im = 0; im < inputMaps_; ++im)
+    {
+        const size_t idx = (om * inputMaps_ + im);
+
+        if (doBias_)
+            ConvolutionMatrix::fprop_bias<Float, ActFunc>(
+                    &input[im * mapSizeInput],
+                    &bias_[idx * mapSizeOutput],
+                    &output[idx * mapSizeOutput],
+                    &weight_[idx * mapSizeWeight],
+                    inputWidth_, inputHeight_,
+                    kernelWidth_, kernelHeight_,
+                    strideX_, strideY_);
+        else
+            ConvolutionMatrix::fprop<Float, ActFunc>(
+                    &input[im * mapSizeInput],
+                    &output[idx * mapSizeOutput],
+                    &weight_[idx * mapSizeWeight],
+                    inputWidth_, inputHeight_,
+                    kernelWidth_, kernelHeight_,
+                    strideX_, strideY_);
+    }
 }
 
 
@@ -269,8 +402,6 @@ void MNN_CONVOLUTION::bprop(const Float * error, Float * error_output,
             mapSizeOutput = scanWidth_ * scanHeight_;
 
     // get error derivatives
-    if (outputErr_.size() != output_.size())
-        outputErr_.resize(output_.size());
     for (size_t i=0; i<output_.size(); ++i)
         outputErr_[i] = ActFunc::derivative(error[i], output_[i]);
 
@@ -299,23 +430,23 @@ void MNN_CONVOLUTION::bprop(const Float * error, Float * error_output,
             bias_[i] += global_learn_rate * learnRateBias_ * outputErr_[i];
 
     // adjust weights
-    if (weightBuffer_.size() != mapSizeWeight)
-        weightBuffer_.resize(mapSizeWeight);
+    optimizer_->nextStep();
     for (size_t om = 0; om < parallelMaps_; ++om)
     for (size_t im = 0; im < inputMaps_; ++im)
     {
         const size_t idx = (om * inputMaps_ + im);
 
-        ConvolutionMatrix::gradient_descent<Float>(
+        ConvolutionMatrix::gradient<Float>(
                     &input_     [im * mapSizeInput],
                     &outputErr_ [idx * mapSizeOutput],
-                    &weight_    [idx * mapSizeWeight],
-                    &prevDelta_ [idx * mapSizeWeight],
                     &weightBuffer_[0],
                     inputWidth_, inputHeight_,
                     kernelWidth_, kernelHeight_,
-                    strideX_, strideY_,
-                    global_learn_rate * learnRate_, momentum_);
+                    strideX_, strideY_);
+
+        optimizer_->update(&weight_[idx * mapSizeWeight], idx * mapSizeWeight,
+                           &weightBuffer_[0], mapSizeWeight,
+                           global_learn_rate * learnRate_);
     }
 }
 
@@ -333,6 +464,19 @@ Float MNN_CONVOLUTION::getWeightAverage() const
     return a;
 }
 
+MNN_TEMPLATE
+void MNN_CONVOLUTION::getMemoryUsage(MemoryUsage& usage) const
+{
+    usage.parameters += (weight_.size() + bias_.size()) * sizeof(Float);
+    usage.state += optimizer_->stateBytes();
+    // views are counted by the owner
+    if (!input_.isView())
+        usage.activations += input_.size() * sizeof(Float);
+    if (!output_.isView())
+        usage.activations += output_.size() * sizeof(Float);
+    usage.scratch += (outputErr_.size() + weightBuffer_.size()) * sizeof(Float);
+}
+
 MNN_TEMPLATE
 void MNN_CONVOLUTION::info(std::ostream& out,
                            const std::string& pf) const
@@ -341,8 +485,10 @@ void MNN_CONVOLUTION::info(std::ostream& out,
         << "\n" << pf << "learnrate  : " << learnRate_;
     if (doBias_)
         out << " (bias " << learnRateBias_ << ")";
-    out << "\n" << pf << "momentum   : " << momentum_
-        << "\n" << pf << "activation : " << ActFunc::static_name()
+    out << "\n" << pf << "momentum   : " << momentum()
+        << "\n" << pf << "optimizer  : ";
+    optimizer_->info(out);
+    out << "\n" << pf << "activation : " << ActFunc::static_name()
         << "\n" << pf << "inputs     : " << numIn() << " ("
                       << inputWidth_ << "x" << inputHeight_;
     if (inputMaps_ > 1)
@@ -360,6 +506,7 @@ void MNN_CONVOLUTION::info(std::ostream& out,
     if (outMaps > 1)
         out << " x " << outMaps;
     out << "\n" << pf << "parameters : " << numParameters()
+        << "\n" << pf << "memory     : " << this->memoryUsage()
         << std::endl;
 }
 
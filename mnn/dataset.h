@@ -0,0 +1,88 @@
+/** @file dataset.h
+
+    @brief Interface to sets of training samples
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_DATASET_H
+#define MNNSRC_DATASET_H
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+
+namespace MNN {
+
+/** Interface to a set of supervised training samples.
+    All methods are const and must be callable from multiple threads. */
+template <typename Float>
+class DataSetInterface
+{
+public:
+    virtual ~DataSetInterface() { }
+
+    virtual size_t numSamples() const = 0;
+    virtual size_t numIn() const = 0;
+    virtual size_t numOut() const = 0;
+
+    /** Returns the input of sample @p index, valid as long as the set */
+    virtual const Float* input(size_t index) const = 0;
+
+    /** Writes the numOut() expected values of sample @p index */
+    virtual void expectedOutput(size_t index, Float* output) const = 0;
+};
+
+
+/** Adapter for image classification sets with
+    width(), height(), numSamples(), numClasses(), image() and label().
+    The expected output is 1 for the label and 0 otherwise.
+
+    With an AugmentFunc, input() returns the augmented image in a
+    buffer of the calling thread, which is valid until the next call
+    to input() on that thread. */
+template <typename Float, class Set>
+class ClassifierDataSet : public DataSetInterface<Float>
+{
+public:
+    /** Writes numIn() values of the (randomly) changed sample @p index
+        to @p output. Called concurrently, so random numbers must come
+        from Random::local(). */
+    typedef std::function<void(const Set& set, size_t index, Float* output)> AugmentFunc;
+
+    explicit ClassifierDataSet(const Set& set, AugmentFunc augment = AugmentFunc())
+        : set_(set), augment_(augment) { }
+
+    void setAugmentFunc(AugmentFunc f) { augment_ = f; }
+
+    virtual size_t numSamples() const override { return set_.numSamples(); }
+    virtual size_t numIn() const override { return set_.width() * set_.height(); }
+    virtual size_t numOut() const override { return set_.numClasses(); }
+    virtual const Float* input(size_t index) const override
+    {
+        if (!augment_)
+            return set_.image(index);
+
+        static thread_local std::vector<Float> buffer;
+        buffer.resize(numIn());
+        augment_(set_, index, &buffer[0]);
+        return &buffer[0];
+    }
+    virtual void expectedOutput(size_t index, Float* output) const override
+    {
+        const size_t label = set_.label(index);
+        for (size_t i = 0; i < numOut(); ++i)
+            output[i] = i == label ? Float(1) : Float(0);
+    }
+
+private:
+    const Set& set_;
+    AugmentFunc augment_;
+};
+
+} // namespace MNN
+
+#endif // MNNSRC_DATASET_H
@@ -0,0 +1,118 @@
+/** @file evaluator.h
+
+    @brief Multi-threaded evaluation of a network on a data set
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_EVALUATOR_H
+#define MNNSRC_EVALUATOR_H
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "layer.h"
+#include "dataset.h"
+#include "thread_pool.h"
+
+namespace MNN {
+
+/** Result of Evaluator::evaluate() */
+struct EvaluationStats
+{
+    EvaluationStats() { clear(); }
+
+    void clear()
+    {
+        numSamples = numErrors = 0;
+        errorSum = seconds = 0.;
+        for (auto& e : errorsPerClass)
+            e = 0;
+    }
+
+    /** Average absolute error per output */
+    double averageError() const { return numSamples ? errorSum / numSamples : 0.; }
+    /** Fraction of samples where the largest output is not the expected one */
+    double errorRate() const { return numSamples ? double(numErrors) / numSamples : 0.; }
+    double samplesPerSecond() const { return seconds > 0. ? numSamples / seconds : 0.; }
+
+    size_t numSamples, numErrors;
+    double errorSum, seconds;
+    /** Number of wrong answers for each expected class
+        (the largest expected output) */
+    std::vector<size_t> errorsPerClass;
+};
+
+
+/** Runs all samples of a data set through a network on multiple threads.
+
+    The data set is split into one continuous range per thread.
+    All threads share the network read-only through Layer::inferBatch(),
+    each with it's own Workspace and buffers. Each thread gathers
+    batchSize() inputs at a time, so that the dense layers use
+    each weight for a block of samples.
+
+    Results are identical for any thread count, except for the last
+    bits of EvaluationStats::errorSum.
+*/
+template <typename Float>
+class Evaluator
+{
+    Evaluator(const Evaluator&) = delete;
+    void operator = (const Evaluator&) = delete;
+
+public:
+
+    /** Creates @p numThreads workers, one per core if 0 */
+    explicit Evaluator(size_t numThreads = 0);
+
+    size_t numThreads() const { return pool_.numThreads(); }
+
+    /** Number of samples per Layer::inferBatch() call, default 64 */
+    void setBatchSize(size_t num) { batchSize_ = std::max(size_t(1), num); }
+    size_t batchSize() const { return batchSize_; }
+
+    /** Evaluates all samples of @p data */
+    const EvaluationStats& evaluate(const Layer<Float>& net,
+                                    const DataSetInterface<Float>& data);
+
+    /** Result of last evaluate() */
+    const EvaluationStats& stats() const { return stats_; }
+
+    /** Index of the largest output for each sample of the last evaluate() */
+    const std::vector<int>& answers() const { return answer_; }
+
+private:
+
+    struct Thread
+    {
+        Workspace<Float> workspace;
+        /** batchSize() inputs and outputs */
+        std::vector<Float> input, output, expected;
+        EvaluationStats stats;
+    };
+
+    void run_(Thread& t, const Layer<Float>& net, const DataSetInterface<Float>& data,
+              size_t begin, size_t end);
+    /** Compares @p output of sample @p k with the expected output */
+    void addSample_(Thread& t, const DataSetInterface<Float>& data,
+                    size_t k, const Float* output);
+
+    ThreadPool pool_;
+    size_t batchSize_;
+    std::vector<Thread> thread_;
+    std::vector<int> answer_;
+    EvaluationStats stats_;
+};
+
+#include "evaluator_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_EVALUATOR_H
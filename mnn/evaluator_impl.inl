@@ -0,0 +1,129 @@
+/** @file evaluator_impl.inl
+
+    @brief Evaluator implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_EVALUATOR Evaluator<Float>
+
+MNN_TEMPLATE
+MNN_EVALUATOR::Evaluator(size_t numThreads)
+    : pool_     (numThreads)
+    , batchSize_(64)
+    , thread_   (pool_.numThreads())
+{
+}
+
+MNN_TEMPLATE
+const EvaluationStats& MNN_EVALUATOR::evaluate(
+        const Layer<Float>& net, const DataSetInterface<Float>& data)
+{
+    if (data.numIn() != net.numIn() || data.numOut() != net.numOut())
+        MNN_EXCEPTION("Data set size " << data.numIn() << " -> " << data.numOut()
+                      << " does not match network " << net.numIn() << " -> "
+                      << net.numOut() << " in Evaluator");
+
+    const auto start = std::chrono::steady_clock::now();
+
+    const size_t num = data.numSamples(),
+                 numT = thread_.size(),
+                 wsSize = net.workspaceSizeBatch(batchSize_);
+    answer_.resize(num);
+
+    pool_.parallelFor(numT, [&](size_t r)
+    {
+        Thread& t = thread_[r];
+        t.stats.errorsPerClass.resize(data.numOut());
+        t.stats.clear();
+
+        const size_t begin = r * num / numT,
+                     end = (r + 1) * num / numT;
+        if (begin < end)
+        {
+            t.workspace.reserve(wsSize);
+            t.input.resize(batchSize_ * net.numIn());
+            t.output.resize(batchSize_ * net.numOut());
+            t.expected.resize(net.numOut());
+            run_(t, net, data, begin, end);
+        }
+    });
+
+    // merge in thread order
+    stats_.errorsPerClass.resize(data.numOut());
+    stats_.clear();
+    for (auto& t : thread_)
+    {
+        stats_.numSamples += t.stats.numSamples;
+        stats_.numErrors += t.stats.numErrors;
+        stats_.errorSum += t.stats.errorSum;
+        for (size_t i = 0; i < stats_.errorsPerClass.size(); ++i)
+            stats_.errorsPerClass[i] += t.stats.errorsPerClass[i];
+    }
+    stats_.seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+
+    return stats_;
+}
+
+MNN_TEMPLATE
+void MNN_EVALUATOR::run_(Thread& t, const Layer<Float>& net,
+                         const DataSetInterface<Float>& data,
+                         size_t begin, size_t end)
+{
+    const size_t numIn = net.numIn(),
+                 numOut = net.numOut();
+    for (size_t b0 = begin; b0 < end; b0 += batchSize_)
+    {
+        const size_t num = std::min(batchSize_, end - b0);
+
+        // gather the inputs of the batch
+        for (size_t b = 0; b < num; ++b)
+        {
+            const Float* in = data.input(b0 + b);
+            std::copy(in, in + numIn, &t.input[b * numIn]);
+        }
+
+        net.inferBatch(&t.input[0], &t.output[0], num, t.workspace);
+
+        for (size_t b = 0; b < num; ++b)
+            addSample_(t, data, b0 + b, &t.output[b * numOut]);
+    }
+}
+
+MNN_TEMPLATE
+void MNN_EVALUATOR::addSample_(Thread& t, const DataSetInterface<Float>& data,
+                               size_t k, const Float* output)
+{
+    const size_t numOut = t.expected.size();
+    data.expectedOutput(k, &t.expected[0]);
+
+    Float sum = 0;
+    size_t maxOut = 0, maxExp = 0;
+    for (size_t i = 0; i < numOut; ++i)
+    {
+        sum += std::abs(t.expected[i] - output[i]);
+        if (output[i] > output[maxOut])
+            maxOut = i;
+        if (t.expected[i] > t.expected[maxExp])
+            maxExp = i;
+    }
+
+    answer_[k] = int(maxOut);
+    if (numOut)
+        t.stats.errorSum += sum / numOut;
+    if (maxOut != maxExp)
+    {
+        ++t.stats.numErrors;
+        ++t.stats.errorsPerClass[maxExp];
+    }
+    ++t.stats.numSamples;
+}
+
+
+#undef MNN_TEMPLATE
+#undef MNN_EVALUATOR
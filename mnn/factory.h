@@ -11,9 +11,17 @@
 #ifndef MNNSRC_FACTORY_H
 #define MNNSRC_FACTORY_H
 
+#include <cstring>
+#include <cstdlib>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
 
 #include "exception.h"
+#include "thread_pool.h"
+#include "text_io.h"
 #include "layer.h"
 #include "activation.h"
 #include "feedforward.h"
@@ -35,12 +43,100 @@ public:
     static Layer<Float>* createLayer(const std::string& id);
 
     /** Loads a complete network or single layer.
+        The layers of stacks are parsed concurrently,
+        see createFromStream().
         @throws MNN::Exception */
-    static Layer<Float>* loadTextFile(const std::string& fn);
+    static Layer<Float>* loadTextFile(const std::string& fn, ThreadPool* pool = nullptr);
+
+    /** Loads a complete network or single layer from
+        the binary model format, see BinaryWriter.
+        The layers of stacks are read concurrently,
+        see createFromBinary().
+        @throws MNN::Exception */
+    static Layer<Float>* loadBinaryFile(const std::string& fn, ThreadPool* pool = nullptr);
+
+    /** Loads a complete network or single layer from
+        the binary model format, with the parameters left
+        in a read-only memory mapping of the file.
+
+        Meant for inference: loading is nearly instant and
+        processes mapping the same file share one copy of the
+        parameters. The values are moved to own memory on the first
+        write, e.g. by training. The mapping is closed when the last
+        layer, or copy of a layer, that uses it is destroyed.
+        On systems without memory-mapping it's the same as loadBinaryFile().
+        @throws MNN::Exception */
+    static Layer<Float>* mapBinaryFile(const std::string& fn);
+
+    /** Loads a network from a binary or text file,
+        depending on the contents.
+        @throws MNN::Exception */
+    static Layer<Float>* loadFile(const std::string& fn, ThreadPool* pool = nullptr);
+
+    /** Saves a complete network or single layer in the binary format.
+        @throws MNN::Exception */
+    static void saveBinaryFile(const Layer<Float>& layer, const std::string& fn)
+        { layer.saveBinaryFile(fn); }
+
+    /** Creates the network from the text format in the rest of @p s.
+
+        The stream is read into memory in one go, so it does not
+        need to be seekable, e.g. a pipe. A scan over the text
+        finds the layer boundaries, then all layers except the
+        stacks are parsed concurrently on @p pool.
+        If @p pool is NULL, a temporary pool is used for large models.
+        @throws MNN::Exception */
+    static Layer<Float>* createFromStream(std::istream& s, ThreadPool* pool = nullptr);
+
+    /** Creates the network from the next layer record in @p reader,
+        which must be past the header.
+        The records of the layers in stacks are read concurrently,
+        like in createFromStream(). With a memory-mapped reader
+        no temporary pool is started, since there is little to do.
+        @throws MNN::Exception */
+    static Layer<Float>* createFromBinary(BinaryReader& reader, ThreadPool* pool = nullptr);
 
 private:
 
-    static Layer<Float>* createFromStream_(std::istream&);
+    /** A layer found by the index scan */
+    struct Record_
+    {
+        Record_() : isStack(false), begin(0), end(0) { }
+        std::unique_ptr<Layer<Float>> layer;
+        bool isStack;
+        /** Byte range of a layer which is not a stack */
+        size_t begin, end;
+        /** Record indices of the layers of a stack */
+        std::vector<size_t> children;
+    };
+
+    /** Minimum size of the layers in bytes for a temporary thread pool */
+    static const size_t parallelBytes_ = size_t(1) << 20;
+
+    static bool isLayerId_(const char* str, size_t len);
+    static bool isStackId_(const std::string& id)
+        { return id == StackSerial<Float>::static_id()
+              || id == StackParallel<Float>::static_id(); }
+
+    /** Returns the positions of all layer ids in the text @p data */
+    static std::vector<size_t> findLayerIds_(const char* data, size_t size, ThreadPool* pool);
+    /** Adds the records of the layer at @p pos in the text @p data
+        and moves @p pos to the end of the layer */
+    static void indexText_(const char* data, size_t size, size_t& pos,
+                           const std::vector<size_t>& ids, std::vector<Record_>& records);
+    /** Adds the records of the next layer in @p r and moves past it */
+    static void indexBinary_(BinaryReader& r, std::vector<Record_>& records);
+    /** Returns @p pool, or a temporary pool in @p tmp
+        if @p bytes are worth it, or NULL */
+    static ThreadPool* threads_(ThreadPool* pool, size_t bytes, size_t maxThreads,
+                                std::unique_ptr<ThreadPool>& tmp);
+    /** Calls @p func(record) for each layer which is not a stack,
+        concurrently if @p pool is not NULL */
+    template <class Func>
+    static void forEachLayer_(std::vector<Record_>& records, ThreadPool* pool,
+                              const Func& func);
+    /** Fills the stacks with their layers and returns the top-most layer */
+    static Layer<Float>* assemble_(std::vector<Record_>& records);
 };
 
 #include "factory_impl.inl"
@@ -58,75 +58,327 @@ Layer<Float>* Factory<Float>::createLayer(const std::string& id)
 
 
 template <typename Float>
-Layer<Float>* Factory<Float>::loadTextFile(const std::string& filename)
+bool Factory<Float>::isLayerId_(const char* str, size_t len)
+{
+    // numbers are the most frequent tokens
+    if (!len || str[0] < 'a' || str[0] > 'z')
+        return false;
+
+    const char* ids[] = {
+        FeedForward<Float, Activation::Linear>::static_id(),
+        Convolution<Float, Activation::Linear>::static_id(),
+        Rbm<Float, Activation::Linear>::static_id(),
+        StackSerial<Float>::static_id(),
+        StackParallel<Float>::static_id() };
+    for (auto id : ids)
+        if (std::strlen(id) == len && std::memcmp(id, str, len) == 0)
+            return true;
+    return false;
+}
+
+
+template <typename Float>
+Layer<Float>* Factory<Float>::loadTextFile(const std::string& filename, ThreadPool* pool)
 {
     std::fstream fs;
     fs.open(filename, std::ios_base::in);
     if (!fs.is_open())
         MNN_EXCEPTION("Could not open file for reading '" << filename << "'");
 
-    return createFromStream_(fs);
+    return createFromStream(fs, pool);
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::loadBinaryFile(const std::string& filename, ThreadPool* pool)
+{
+    BinaryReader r;
+    r.readFile(filename);
+    r.readHeader();
+    return createFromBinary(r, pool);
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::mapBinaryFile(const std::string& filename)
+{
+#ifdef MNN_HAVE_MMAP
+    BinaryReader r;
+    r.mapFile(filename);
+    r.readHeader();
+    return createFromBinary(r);
+#else
+    return loadBinaryFile(filename);
+#endif
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::loadFile(const std::string& filename, ThreadPool* pool)
+{
+    if (Binary::isBinaryFile(filename))
+        return loadBinaryFile(filename, pool);
+    return loadTextFile(filename, pool);
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::createFromBinary(BinaryReader& r, ThreadPool* pool)
+{
+    std::vector<Record_> records;
+    indexBinary_(r, records);
+
+    // a mapping leaves little to do
+    size_t bytes = 0, num = 0;
+    if (!r.isMapped())
+        for (auto& rec : records)
+        if (!rec.isStack)
+        {
+            bytes += rec.end - rec.begin;
+            ++num;
+        }
+    std::unique_ptr<ThreadPool> tmp;
+    pool = threads_(pool, bytes, num, tmp);
+
+    forEachLayer_(records, pool, [&](Record_& rec)
+    {
+        BinaryReader sub;
+        sub.viewRange(r, rec.begin, rec.end - rec.begin);
+        rec.layer->deserializeBinary(sub);
+    });
+
+    return assemble_(records);
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::createFromStream(std::istream& s, ThreadPool* pool)
+{
+    std::string text;
+    Text::readAll(s, text);
+
+    std::unique_ptr<ThreadPool> tmp;
+    pool = threads_(pool, text.size(), ThreadPool::numCores(), tmp);
+
+    std::vector<Record_> records;
+    size_t pos = 0;
+    indexText_(text.data(), text.size(), pos,
+               findLayerIds_(text.data(), text.size(), pool), records);
+
+    const std::locale loc = s.getloc();
+    forEachLayer_(records, pool, [&](Record_& rec)
+    {
+        Text::MemoryBuf buf(text.data() + rec.begin, rec.end - rec.begin);
+        std::istream is(&buf);
+        is.imbue(loc);
+        // deserialize using layer's implementation
+        rec.layer->deserialize(is);
+    });
+
+    return assemble_(records);
+}
+
+template <typename Float>
+ThreadPool* Factory<Float>::threads_(ThreadPool* pool, size_t bytes, size_t maxThreads,
+                                     std::unique_ptr<ThreadPool>& tmp)
+{
+    if (pool)
+        return pool;
+    const size_t num = std::min(ThreadPool::numCores(), maxThreads);
+    if (bytes < parallelBytes_ || num < 2)
+        return nullptr;
+    tmp.reset(new ThreadPool(num));
+    return tmp.get();
+}
+
+template <typename Float>
+void Factory<Float>::indexBinary_(BinaryReader& r, std::vector<Record_>& records)
+{
+    const auto header = r.peekLayer();
+
+    // create the required layer
+    const size_t index = records.size();
+    records.push_back(Record_());
+    records[index].layer.reset(createLayer(header.id, header.activation));
+    if (!records[index].layer)
+        MNN_EXCEPTION("Could not create layer '" << header.id << "' for deserialization");
+
+    // stacks are filled with new sub-layers
+    if (isStackId_(header.id))
+    {
+        const uint32_t ver = r.beginLayer(header.id);
+        if (ver > 1)
+            MNN_EXCEPTION("Wrong version (" << ver << ") in '" << header.id << "'");
+        const size_t num = size_t(r.readUInt());
+
+        records[index].isStack = true;
+        for (size_t i = 0; i < num; ++i)
+        {
+            const size_t child = records.size();
+            indexBinary_(r, records);
+            records[index].children.push_back(child);
+        }
+        r.endLayer();
+        return;
+    }
+
+    // the payload size gives the end of the record
+    records[index].begin = r.position();
+    r.skipLayer();
+    records[index].end = r.position();
 }
 
 template <typename Float>
-Layer<Float>* Factory<Float>::createFromStream_(std::istream& fs)
+std::vector<size_t> Factory<Float>::findLayerIds_(const char* data, size_t size,
+                                                  ThreadPool* pool)
 {
-    // store position
-    size_t pos = fs.tellg();
+    // each chunk collects the tokens starting within it,
+    // which can not be confused with numbers, activations or optimizers
+    const size_t numChunks = pool ? pool->numThreads() * 4 : 1;
+    std::vector<std::vector<size_t>> found(numChunks);
+    auto scan = [data, size, numChunks, &found](size_t chunk)
+    {
+        const size_t len = size / numChunks,
+                     end = chunk + 1 == numChunks ? size : len * (chunk + 1);
+        for (size_t i = len * chunk; i < end; ++i)
+        {
+            while (i + 8 <= end && !Text::mayHaveLetter8_(data + i))
+                i += 8;
+            if (i >= end)
+                break;
+            if (data[i] < 'a' || data[i] > 'z'
+                || (i > 0 && !Text::isSpace_(data[i - 1])))
+                continue;
+            size_t j = i;
+            while (j < size && !Text::isSpace_(data[j]))
+                ++j;
+            if (isLayerId_(data + i, j - i))
+                found[chunk].push_back(i);
+            i = j;
+        }
+    };
+    if (pool)
+        pool->parallelFor(numChunks, scan);
+    else
+        scan(0);
+
+    std::vector<size_t> ids;
+    for (auto& f : found)
+        ids.insert(ids.end(), f.begin(), f.end());
+    return ids;
+}
+
+template <typename Float>
+void Factory<Float>::indexText_(const char* data, size_t size, size_t& pos,
+                                const std::vector<size_t>& ids,
+                                std::vector<Record_>& records)
+{
+    auto skipSpace = [&]()
+    {
+        while (pos < size && Text::isSpace_(data[pos]))
+            ++pos;
+    };
+    auto token = [&]()
+    {
+        skipSpace();
+        const size_t start = pos;
+        while (pos < size && !Text::isSpace_(data[pos]))
+            ++pos;
+        return std::string(data + start, pos - start);
+    };
 
     // read layer id and activation
     // (if layer does not have activation it's ignored)
-    std::string id, act;
-    fs >> id >> act;
-
-    // return to start of layer description
-    fs.seekg(pos, std::ios_base::beg);
+    skipSpace();
+    const size_t begin = pos;
+    const std::string id = token(), act = token();
+    if (id.empty())
+        MNN_EXCEPTION("Unexpected end of stream, expected a layer");
 
     // create the required layer
-    auto layer = createLayer(id, act);
-    if (!layer)
+    const size_t index = records.size();
+    records.push_back(Record_());
+    records[index].layer.reset(createLayer(id, act));
+    if (!records[index].layer)
         MNN_EXCEPTION("Could not create layer '" << id << "' for deserialization");
 
     // handle special case of stacks
-    if (id == StackSerial<Float>::static_id()
-     || id == StackParallel<Float>::static_id())
+    if (isStackId_(id))
     {
-        // id
-        fs >> id;
-        // version
-        int ver;
-        fs >> ver;
+        // version (in place of the activation)
+        char* end;
+        const long ver = std::strtol(act.c_str(), &end, 10);
+        if (act.empty() || *end)
+            MNN_EXCEPTION("Expected version of '" << id << "' in stream, found '"
+                          << act << "'");
         if (ver > 1)
             MNN_EXCEPTION("Wrong version (" << ver << ") in '" << id << "'");
         // num layers
-        size_t num;
-        fs >> num;
+        const std::string numStr = token();
+        const unsigned long long num = std::strtoull(numStr.c_str(), &end, 10);
+        if (numStr.empty() || *end)
+            MNN_EXCEPTION("Expected number of layers of '" << id << "' in stream, found '"
+                          << numStr << "'");
 
-        // each layer
-        for (size_t i = 0; i < num; ++i)
+        records[index].isStack = true;
+        for (unsigned long long i = 0; i < num; ++i)
         {
-            auto sub = createFromStream_(fs);
+            const size_t child = records.size();
+            indexText_(data, size, pos, ids, records);
+            records[index].children.push_back(child);
+        }
+        return;
+    }
+
+    // the layer reaches up to the next layer id
+    records[index].begin = begin;
+    auto next = std::upper_bound(ids.begin(), ids.end(), begin);
+    pos = next == ids.end() ? size : *next;
+    records[index].end = pos;
+}
+
+template <typename Float>
+template <class Func>
+void Factory<Float>::forEachLayer_(std::vector<Record_>& records, ThreadPool* pool,
+                                   const Func& func)
+{
+    std::vector<Record_*> layers;
+    for (auto& rec : records)
+        if (!rec.isStack)
+            layers.push_back(&rec);
+
+    if (!pool || layers.size() < 2)
+    {
+        for (auto rec : layers)
+            func(*rec);
+        return;
+    }
+
+    // largest layers first, so the small ones fill the gaps
+    std::stable_sort(layers.begin(), layers.end(), [](const Record_* a, const Record_* b)
+    {
+        return a->end - a->begin > b->end - b->begin;
+    });
+    pool->parallelFor(layers.size(), [&](size_t i) { func(*layers[i]); });
+}
+
+template <typename Float>
+Layer<Float>* Factory<Float>::assemble_(std::vector<Record_>& records)
+{
+    // sub-stacks follow their stack, so they are complete before being added
+    for (size_t i = records.size(); i-- > 0; )
+    {
+        auto& rec = records[i];
+        for (auto child : rec.children)
+        {
+            auto sub = records[child].layer.release();
             // XXX TODO could use an interface here
-            if (auto stack = dynamic_cast<StackSerial<Float>*>(layer))
+            if (auto stack = dynamic_cast<StackSerial<Float>*>(rec.layer.get()))
                 stack->add(sub);
             else
-            if (auto stack = dynamic_cast<StackParallel<Float>*>(layer))
+            if (auto stack = dynamic_cast<StackParallel<Float>*>(rec.layer.get()))
                 stack->add(sub);
             else
             {
                 delete sub;
-                MNN_EXCEPTION("Wrong stack object '" << layer->id() << "'");
+                MNN_EXCEPTION("Wrong stack object '" << rec.layer->id() << "'");
             }
         }
-
-        return layer;
     }
-
-    // return to start of layer description
-    fs.seekg(pos, std::ios_base::beg);
-
-    // deserialize using layer's implementation
-    layer->deserialize(fs);
-
-    return layer;
+    return records.empty() ? nullptr : records[0].layer.release();
 }
@@ -0,0 +1,201 @@
+/** @file feature_matrix.h
+
+    @brief Contiguous matrix of feature vectors
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_FEATURE_MATRIX_H
+#define MNNSRC_FEATURE_MATRIX_H
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "layer.h"
+#include "workspace.h"
+#include "thread_pool.h"
+#include "mapped_file.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** Row-major matrix of numRows() vectors with numCols() values each,
+    e.g. the outputs of a trained layer for every sample of a dataset.
+
+    The values are either held in memory or in a memory-mapped
+    file, see resizeMapped(), so that large feature sets can be
+    paged out by the system.
+
+    compute() fills the matrix by streaming all rows through
+    a chain of layers in parallel batches:
+
+    @code
+    FeatureMatrix<float> features;
+    features.compute({ layer0, layer1 }, numSamples,
+                     [&](size_t i) { return sample(i); }, &pool);
+    // train next layer from features.row(i)
+    @endcode
+*/
+template <typename Float>
+class FeatureMatrix
+{
+    FeatureMatrix(const FeatureMatrix&) = delete;
+    void operator = (const FeatureMatrix&) = delete;
+
+public:
+
+    FeatureMatrix() : numRows_(0), numCols_(0), data_(nullptr) { }
+
+    // ------------ getter ---------------
+
+    size_t numRows() const { return numRows_; }
+    size_t numCols() const { return numCols_; }
+    size_t size() const { return numRows_ * numCols_; }
+    bool empty() const { return size() == 0; }
+
+    /** True if the values are stored in a memory-mapped file */
+    bool isMapped() const { return file_.isOpen(); }
+
+    const Float* data() const { return data_; }
+    Float* data() { return data_; }
+
+    const Float* row(size_t index) const { return data_ + index * numCols_; }
+    Float* row(size_t index) { return data_ + index * numCols_; }
+
+    // ------------ setter ---------------
+
+    /** Sets the size, held in memory. Contents are undefined. */
+    void resize(size_t numRows, size_t numCols)
+    {
+        file_.close();
+        mem_.resize(numRows * numCols);
+        setSize_(numRows, numCols, mem_.empty() ? nullptr : &mem_[0]);
+    }
+
+    /** Sets the size, stored in the file @p filename,
+        which is created or overwritten. Contents are undefined. */
+    void resizeMapped(const std::string& filename, size_t numRows, size_t numCols)
+    {
+        std::vector<Float>().swap(mem_);
+        file_.create(filename, numRows * numCols * sizeof(Float));
+        setSize_(numRows, numCols, reinterpret_cast<Float*>(file_.data()));
+    }
+
+    /** Releases the memory or the mapping */
+    void clear()
+    {
+        file_.close();
+        std::vector<Float>().swap(mem_);
+        setSize_(0, 0, nullptr);
+    }
+
+    void swap(FeatureMatrix& other)
+    {
+        // the mapping can not be moved, so swap the parts
+        std::swap(numRows_, other.numRows_);
+        std::swap(numCols_, other.numCols_);
+        std::swap(data_, other.data_);
+        mem_.swap(other.mem_);
+        file_.swap(other.file_);
+    }
+
+    // ------------ compute --------------
+
+    /** Propagates @p numRows input vectors through the chain of @p layers
+        and stores the output of the last layer in each row.
+        The matrix is resized to numRows x layers.back()->numOut(),
+        unless it already has this size, e.g. from resizeMapped().
+
+        @p getRow(index) must return a pointer to the input vector
+        at index and be callable from several threads.
+        The rows are processed in batches of @p batchSize,
+        in parallel on @p pool if it is not NULL.
+        The layers are only used through Layer::infer(). */
+    template <class RowFunc>
+    void compute(const std::vector<const Layer<Float>*>& layers,
+                 size_t numRows, RowFunc getRow,
+                 ThreadPool* pool = nullptr, size_t batchSize = 256);
+
+private:
+
+    void setSize_(size_t numRows, size_t numCols, Float* data)
+        { numRows_ = numRows; numCols_ = numCols; data_ = data; }
+
+    size_t numRows_, numCols_;
+    Float* data_;
+    std::vector<Float> mem_;
+    MappedFile file_;
+};
+
+
+template <typename Float>
+template <class RowFunc>
+void FeatureMatrix<Float>::compute(
+        const std::vector<const Layer<Float>*>& layers,
+        size_t numRows, RowFunc getRow,
+        ThreadPool* pool, size_t batchSize)
+{
+    if (layers.empty())
+        MNN_EXCEPTION("FeatureMatrix::compute() without layers");
+    for (size_t i = 1; i < layers.size(); ++i)
+        if (layers[i]->numIn() != layers[i-1]->numOut())
+            MNN_EXCEPTION("FeatureMatrix::compute() layer " << i << " expects "
+                          << layers[i]->numIn() << " inputs, previous layer has "
+                          << layers[i-1]->numOut() << " outputs");
+
+    const size_t numCols = layers.back()->numOut();
+    if (numRows_ != numRows || numCols_ != numCols)
+        resize(numRows, numCols);
+
+    // scratch sizes of the chain
+    size_t maxWidth = 0, maxLayer = 0;
+    for (size_t i = 0; i < layers.size(); ++i)
+    {
+        if (i + 1 < layers.size())
+            maxWidth = std::max(maxWidth, layers[i]->numOut());
+        maxLayer = std::max(maxLayer, layers[i]->workspaceSize());
+    }
+
+    batchSize = std::max(batchSize, size_t(1));
+    const size_t numBatches = (numRows + batchSize - 1) / batchSize;
+
+    auto task = [&](size_t batch)
+    {
+        Workspace<Float> workspace(2 * maxWidth + maxLayer);
+        Float * cur = workspace.allocate(maxWidth),
+              * next = workspace.allocate(maxWidth);
+
+        const size_t end = std::min(numRows, (batch + 1) * batchSize);
+        for (size_t r = batch * batchSize; r < end; ++r)
+        {
+            const Float* input = getRow(r);
+            if (layers.size() == 1)
+            {
+                layers[0]->infer(input, row(r), workspace);
+                continue;
+            }
+            layers[0]->infer(input, cur, workspace);
+            for (size_t i = 1; i + 1 < layers.size(); ++i)
+            {
+                layers[i]->infer(cur, next, workspace);
+                std::swap(cur, next);
+            }
+            layers.back()->infer(cur, row(r), workspace);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(numBatches, task);
+    else
+        for (size_t b = 0; b < numBatches; ++b)
+            task(b);
+}
+
+} // namespace MNN
+
+#endif // MNNSRC_FEATURE_MATRIX_H
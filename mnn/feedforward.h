@@ -13,10 +13,12 @@
 
 #include <cmath>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 #include "layer.h"
 #include "interface.h"
+#include "optimizer.h"
 
 namespace MNN {
 
@@ -32,6 +34,8 @@ class FeedForward
         , public SetBiasEnabledInterface
         , public GetMomentumInterface<Float>
         , public SetMomentumInterface<Float>
+        , public GetOptimizerInterface<Float>
+        , public SetOptimizerInterface<Float>
         , public GetSoftmaxInterface
         , public SetSoftmaxInterface
         , public ReconstructionInterface<Float>
@@ -47,6 +51,14 @@ class FeedForward
     virtual FeedForward<Float, ActFunc> * cloneClass() const override
         { return new FeedForward<Float, ActFunc>(numIn(), numOut(), learnRate_, doBias_); }
 
+    /** Starts from an empty layer, so the copy only shares the buffers */
+    virtual FeedForward<Float, ActFunc> * getCopy() const override
+        {
+            auto l = new FeedForward<Float, ActFunc>(0, 0, learnRate_, doBias_);
+            *l = static_cast<const Layer<Float>&>(*this);
+            return l;
+        }
+
     virtual FeedForward<Float, ActFunc>& operator = (const Layer<Float>&) override;
 
     // --------- LearnRateInterface ----------
@@ -66,8 +78,13 @@ class FeedForward
 
     // --------- MomentumInterface -----------
 
-    virtual Float momentum() const override { return momentum_; }
-    virtual void setMomentum(Float m) override { momentum_ = m; }
+    virtual Float momentum() const override { return optimizer_->momentum(); }
+    virtual void setMomentum(Float m) override { optimizer_->setMomentum(m); }
+
+    // --------- OptimizerInterface ----------
+
+    virtual const Optimizer<Float>& optimizer() const override { return *optimizer_; }
+    virtual void setOptimizer(const Optimizer<Float>& opt) override;
 
     // --------- SoftmaxInterface ------------
 
@@ -94,6 +111,14 @@ class FeedForward
     virtual const Float* outputs() const override { return &output_[0]; }
     virtual const Float* weights() const override { return &weight_[0]; }
     virtual Float* weights() override { return &weight_[0]; }
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>&) override;
+    virtual bool setInputStorage(Float* data, const std::shared_ptr<void>& owner) override
+        { input_.setView(data, owner); return true; }
+    virtual bool setOutputStorage(Float* data, const std::shared_ptr<void>& owner) override
+        { output_.setView(data, owner); return true; }
+    virtual void detachStorage() override { input_.detach(); output_.detach(); }
+    virtual void setLean(bool lean) override { optimizer_->setLean(lean); }
+    virtual void releaseTrainingState() override { optimizer_->releaseState(); }
 
     virtual const Float* biases() const { return &bias_[0]; }
     virtual Float* biases() { return &bias_[0]; }
@@ -101,6 +126,10 @@ class FeedForward
     // ------- propagation -------------------
 
     virtual void fprop(const Float * input, Float * output) override;
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const override;
+    virtual void inferBatch(const Float * input, Float * output, size_t num,
+                            Workspace<Float>& workspace) const override;
 
     virtual void bprop(const Float * error, Float * error_output = 0,
                        Float global_learn_rate = 1) override;
@@ -111,6 +140,7 @@ class FeedForward
     virtual const char * id() const override { return static_id(); }
     virtual const char * name() const override { return "FeedForward"; }
     virtual size_t numParameters() const override { return weight_.size() + bias_.size(); }
+    virtual void getMemoryUsage(MemoryUsage&) const override;
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const override;
     virtual void dump(std::ostream &out = std::cout) const override;
@@ -121,24 +151,38 @@ class FeedForward
 
     virtual void serialize(std::ostream&) const override;
     virtual void deserialize(std::istream&) override;
+    virtual void serializeBinary(BinaryWriter&) const override;
+    virtual void deserializeBinary(BinaryReader&) override;
 
 protected:
 
-    std::vector<Float>
+    /** Sizes the scratch buffers for the current input and output size,
+        so that propagation does not need to allocate */
+    void resizeScratch_();
+
+    /** May live in the memory of a StackSerial,
+        see setInputStorage() */
+    Buffer<Float>
         input_,
-        bias_,
-        output_,
-        weight_,
-        prevDelta_,
+        output_;
+
+    std::vector<Float>
         errorDer_,
         // scratch space for reconstruction
         reconInput_,
         reconError_,
-        reconOutput_;
+        reconOutput_,
+        reconGradient_;
+
+    /** Trainable parameters */
+    Buffer<Float>
+        weight_,
+        bias_;
+
+    std::unique_ptr<Optimizer<Float>> optimizer_;
 
     Float learnRate_,
-          learnRateBias_,
-          momentum_;
+          learnRateBias_;
 
     bool doBias_,
          doSoftmax_;
@@ -13,9 +13,9 @@
 
 MNN_TEMPLATE
 MNN_FEEDFORWARD::FeedForward(size_t nrIn, size_t nrOut, Float learnRate, bool doBias)
-    : learnRate_	(learnRate)
+    : optimizer_    (new OptimizerSgd<Float>())
+    , learnRate_	(learnRate)
     , learnRateBias_(.1)
-    , momentum_     (.1)
     , doBias_       (doBias)
     , doSoftmax_    (false)
 {
@@ -39,14 +39,16 @@ FeedForward<Float, ActFunc>& MNN_FEEDFORWARD::operator = (const Layer<Float>& la
     bias_ = net->bias_;
     output_ = net->output_;
     weight_ = net->weight_;
-    prevDelta_ = net->prevDelta_;
+    if (!optimizer_->assign(*net->optimizer_))
+        optimizer_.reset(net->optimizer_->getCopy());
 
     learnRate_ = net->learnRate_;
     learnRateBias_ = net->learnRateBias_;
-    momentum_ = net->momentum_;
     doSoftmax_ = net->doSoftmax_;
     doBias_ = net->doBias_;
 
+    resizeScratch_();
+
     return *this;
 }
 
@@ -60,9 +62,9 @@ void MNN_FEEDFORWARD::serialize(std::ostream& s) const
     // activation
     s << " " << ActFunc::static_name();
     // version
-    s << " " << 1;
+    s << " " << 2;
     // settings
-    s << " " << learnRate_ << " " << momentum_
+    s << " " << learnRate_ << " " << momentum()
       << " " << doBias_ << " " << doSoftmax_ << "\n";
     // dimension
     s << " " << input_.size() << " " << output_.size() << "\n";
@@ -74,6 +76,9 @@ void MNN_FEEDFORWARD::serialize(std::ostream& s) const
     // weights
     for (auto w : weight_)
         s << " " << w;
+    // optimizer (v2)
+    s << "\n";
+    optimizer_->serialize(s);
 }
 
 MNN_TEMPLATE
@@ -89,22 +94,81 @@ void MNN_FEEDFORWARD::deserialize(std::istream& s)
     // version
     int ver;
     s >> ver;
-    if (ver > 1)
+    if (ver > 2)
         MNN_EXCEPTION("Wrong version in " << name());
 
     // settings
-    s >> learnRate_ >> momentum_ >> doBias_ >> doSoftmax_;
+    Float mom;
+    s >> learnRate_ >> mom >> doBias_ >> doSoftmax_;
     // dimension
     size_t numIn, numOut;
     s >> numIn >> numOut;
     resize(numIn, numOut);
     // bias
     if (doBias_)
-        for (auto& b : bias_)
-            s >> b;
+        Text::readValues(s, bias_.data(), bias_.size());
     // weights
-    for (auto& w : weight_)
-        s >> w;
+    Text::readValues(s, weight_.data(), weight_.size());
+    // optimizer
+    if (ver >= 2)
+    {
+        optimizer_.reset(Optimizer<Float>::createFromStream(s));
+        if (optimizer_->numParameters() != weight_.size())
+            MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                          << " does not match " << weight_.size() << " weights in " << name());
+    }
+    else
+    {
+        optimizer_->setMomentum(mom);
+        optimizer_->reset();
+    }
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::serializeBinary(BinaryWriter& w) const
+{
+    w.beginLayer(id(), ActFunc::static_name(), 1);
+    // settings
+    w.writeFloat(learnRate_);
+    w.writeBool(doBias_);
+    w.writeBool(doSoftmax_);
+    // dimension
+    w.writeUInt(input_.size());
+    w.writeUInt(output_.size());
+    // parameters
+    if (doBias_)
+        w.writeBlock(bias_.constData(), bias_.size());
+    w.writeBlock(weight_.constData(), weight_.size());
+    optimizer_->serializeBinary(w);
+    w.endLayer();
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::deserializeBinary(BinaryReader& r)
+{
+    const uint32_t ver = r.beginLayer(id());
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in " << name());
+
+    // settings
+    learnRate_ = Float(r.readFloat());
+    doBias_ = r.readBool();
+    doSoftmax_ = r.readBool();
+    // dimension
+    const size_t numIn = size_t(r.readUInt()),
+                 numOut = size_t(r.readUInt());
+    // parameters, sized by the reader
+    if (doBias_)
+        r.readBlock(bias_, numOut);
+    r.readBlock(weight_, numIn * numOut);
+    // optimizer
+    optimizer_.reset(Optimizer<Float>::createFromBinary(r));
+    if (optimizer_->numParameters() != weight_.size())
+        MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                      << " does not match " << weight_.size() << " weights in " << name());
+    r.endLayer();
+    // only sizes the rest
+    resize(numIn, numOut);
 }
 
 
@@ -117,7 +181,37 @@ void MNN_FEEDFORWARD::resize(size_t nrIn, size_t nrOut)
     output_.resize(nrOut);
     bias_.resize(nrOut);
     weight_.resize(nrIn * nrOut);
-    prevDelta_.resize(nrIn * nrOut);
+    optimizer_->resize(nrIn * nrOut);
+    resizeScratch_();
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::resizeScratch_()
+{
+    errorDer_.resize(output_.size());
+    reconInput_.resize(input_.size());
+    reconError_.resize(input_.size());
+    reconOutput_.resize(output_.size());
+    reconGradient_.resize(input_.size());
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::setOptimizer(const Optimizer<Float>& opt)
+{
+    const bool lean = optimizer_->isLean();
+    optimizer_.reset(opt.getCopy());
+    if (lean)
+        optimizer_->setLean(true);
+    optimizer_->resize(weight_.size());
+    optimizer_->reset();
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    blocks.push_back({ weight_.data(), weight_.size(), PT_PARAMETER, &weight_ });
+    blocks.push_back({ bias_.data(), bias_.size(), PT_PARAMETER, &bias_ });
+    optimizer_->getParameterBlocks(blocks);
 }
 
 MNN_TEMPLATE
@@ -138,7 +232,7 @@ void MNN_FEEDFORWARD::grow(size_t nrIn, size_t nrOut, Float randomDev)
         for (i=0; i<input_.size(); ++i)
             weight[o * nrIn + i] = weight_[o * input_.size() + i];
         // choose random input to copy
-        size_t ri = size_t(rand()) % input_.size();
+        size_t ri = Random::local().index(input_.size());
         // run through additional inputs
         for (; i<nrIn; ++i)
             weight[o * nrIn + i] = weight_[o * input_.size() + ri]
@@ -150,8 +244,8 @@ void MNN_FEEDFORWARD::grow(size_t nrIn, size_t nrOut, Float randomDev)
     for (; o<nrOut; ++o)
     {
         // choose random input and output to copy
-        size_t ro = size_t(rand()) % output_.size();
-        size_t ri = size_t(rand()) % input_.size();
+        size_t ro = Random::local().index(output_.size());
+        size_t ri = Random::local().index(input_.size());
 
         size_t i;
         for (i=0; i<input_.size(); ++i)
@@ -167,7 +261,9 @@ void MNN_FEEDFORWARD::grow(size_t nrIn, size_t nrOut, Float randomDev)
     // resize other buffers
     input_.resize(nrIn); for (auto&f : input_) f = 0;
     output_.resize(nrOut); for (auto&f : output_) f = 0;
-    prevDelta_.resize(nrIn * nrOut); for (auto&f : prevDelta_) f = 0;
+    optimizer_->resize(nrIn * nrOut);
+    optimizer_->reset();
+    resizeScratch_();
 }
 
 
@@ -180,21 +276,18 @@ void MNN_FEEDFORWARD::brainwash(Float amp)
     for (auto& f : output_)
         f = 0.;
     // reset momentum
-    for (auto& m : prevDelta_)
-        m = 0.;
+    optimizer_->reset();
 
     if (input_.empty() || output_.empty())
         return;
 
     // randomize weights (assume normalized states)
     Float f = amp / std::sqrt(input_.size());
-    for (auto e = weight_.begin(); e != weight_.end(); ++e)
-        *e = rnd(-f, f);
+    Random::local().fillUniform(weight_.data(), weight_.size(), -f, f);
 
     // randomize bias
     f = amp / output_.size();
-    for (auto& b : bias_)
-        b = rnd(-f, f);
+    Random::local().fillUniform(bias_.data(), bias_.size(), -f, f);
 }
 
 
@@ -204,24 +297,57 @@ MNN_TEMPLATE
 void MNN_FEEDFORWARD::fprop(const Float * input, Float * output)
 {
     // copy to internal data
-    for (auto i = input_.begin(); i != input_.end(); ++i, ++input)
-        *i = *input;
+    // (unless it's the storage given by setInputStorage())
+    if (input != input_.data())
+        for (auto i = input_.begin(); i != input_.end(); ++i, ++input)
+            *i = *input;
 
     // propagate
     if (doBias_)
         DenseMatrix::fprop_bias<Float, ActFunc>(
-                &input_[0], &output_[0], &bias_[0], &weight_[0],
+                &input_[0], &output_[0], bias_.constData(), weight_.constData(),
                 input_.size(), output_.size());
     else
         DenseMatrix::fprop<Float, ActFunc>(
-                &input_[0], &output_[0], &weight_[0],
+                &input_[0], &output_[0], weight_.constData(),
                 input_.size(), output_.size());
 
     if (doSoftmax_)
         apply_softmax(&output_[0], output_.size());
 
     // copy to caller
-    std::copy(output_.begin(), output_.end(), output);
+    if (output != output_.data())
+        std::copy(output_.begin(), output_.end(), output);
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::infer(const Float * input, Float * output,
+                            Workspace<Float>&) const
+{
+    if (doBias_)
+        DenseMatrix::fprop_bias<Float, ActFunc>(
+                input, output, &bias_[0], &weight_[0],
+                input_.size(), output_.size());
+    else
+        DenseMatrix::fprop<Float, ActFunc>(
+                input, output, &weight_[0],
+                input_.size(), output_.size());
+
+    if (doSoftmax_)
+        apply_softmax(output, output_.size());
+}
+
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::inferBatch(const Float * input, Float * output, size_t num,
+                                 Workspace<Float>&) const
+{
+    DenseMatrix::fprop_bias_batch<Float, ActFunc>(
+                input, output, doBias_ ? bias_.constData() : nullptr,
+                weight_.constData(), input_.size(), output_.size(), num);
+
+    if (doSoftmax_)
+        for (size_t b = 0; b < num; ++b)
+            apply_softmax(output + b * output_.size(), output_.size());
 }
 
 
@@ -230,8 +356,6 @@ void MNN_FEEDFORWARD::bprop(const Float * error, Float * error_output,
                            Float learn_rate)
 {
     // calculate error derivative
-    if (errorDer_.size() != output_.size())
-        errorDer_.resize(output_.size());
     for (size_t i=0; i<output_.size(); ++i)
         errorDer_[i] = ActFunc::derivative(error[i], output_[i]);
 
@@ -245,12 +369,15 @@ void MNN_FEEDFORWARD::bprop(const Float * error, Float * error_output,
     {
         // gradient descent on weights
         if (learnRate_ > 0.)
-            DenseMatrix::gradient_descent<Float, Activation::Linear>(
-                    &input_[0], &output_[0], &errorDer_[0],
-                    &weight_[0], &prevDelta_[0],
-                    input_.size(), output_.size(),
-                    learn_rate * learnRate_,
-                    momentum_);
+        {
+            const size_t numIn = input_.size();
+            optimizer_->nextStep();
+            for (size_t o = 0; o < output_.size(); ++o)
+                optimizer_->updateScaled(
+                            &weight_[o * numIn], o * numIn,
+                            &input_[0], errorDer_[o], numIn,
+                            learn_rate * learnRate_);
+        }
 
         // gradient descent on biases
         if (doBias_ && learnRateBias_ > 0.)
@@ -268,16 +395,16 @@ void MNN_FEEDFORWARD::reconstruct(const Float* input, Float* reconstruction)
     // get code for input
     if (doBias_)
         DenseMatrix::fprop_bias<Float, ActFunc>(
-                input, &output_[0], &bias_[0], &weight_[0],
+                input, &output_[0], bias_.constData(), weight_.constData(),
                 input_.size(), output_.size());
     else
         DenseMatrix::fprop<Float, ActFunc>(
-                input, &output_[0], &weight_[0],
+                input, &output_[0], weight_.constData(),
                 input_.size(), output_.size());
 
     // get reconstruction from code
     DenseMatrix::fprop_transpose<Float, ActFunc>(
-                &output_[0], reconstruction, &weight_[0],
+                &output_[0], reconstruction, weight_.constData(),
                 output_.size(), input_.size());
 }
 
@@ -290,14 +417,6 @@ Float MNN_FEEDFORWARD::reconstructionTraining(
     for (auto i = input_.begin(); i != input_.end(); ++i, ++dec_input)
         *i = *dec_input;
 
-    // get reconstruction space
-    if (reconInput_.size() != input_.size())
-        reconInput_.resize(input_.size());
-    if (reconError_.size() != input_.size())
-        reconError_.resize(input_.size());
-    if (reconOutput_.size() != output_.size())
-        reconOutput_.resize(output_.size());
-
     // get code for input
     if (doBias_)
         DenseMatrix::fprop_bias<Float, ActFunc>(
@@ -335,21 +454,21 @@ Float MNN_FEEDFORWARD::reconstructionTraining(
                 &reconError_[0], &reconOutput_[0], &weight_[0],
                 input_.size(), output_.size());
 
-    // gradient descent using reconstruction error
-    DenseMatrix::gradient_descent_transpose<Float, Activation::Linear>(
-                &output_[0], &reconInput_[0], &reconError_[0],
-                &weight_[0], &prevDelta_[0],
-                output_.size(), input_.size(),
-                global_learn_rate * learnRate_,
-                momentum_);
-
-    // gradient descent using code error
-    DenseMatrix::gradient_descent<Float, Activation::Linear>(
-                &input_[0], &output_[0], &reconOutput_[0],
-                &weight_[0], &prevDelta_[0],
-                input_.size(), output_.size(),
-                global_learn_rate * learnRate_,
-                momentum_);
+    // gradient descent using reconstruction error (decoder)
+    // and code error (encoder) for each row of the tied weights
+    const size_t numIn = input_.size();
+    optimizer_->nextStep();
+    for (size_t o = 0; o < output_.size(); ++o)
+    {
+        const Float codeErr = reconOutput_[o],
+                    code = output_[o];
+        for (size_t i = 0; i < numIn; ++i)
+            reconGradient_[i] = code * reconError_[i] + codeErr * input_[i];
+
+        optimizer_->update(&weight_[o * numIn], o * numIn,
+                           &reconGradient_[0], numIn,
+                           global_learn_rate * learnRate_);
+    }
 
     // gradient descent on biases using code error
     if (doBias_)
@@ -376,6 +495,20 @@ Float MNN_FEEDFORWARD::getWeightAverage() const
     return a;
 }
 
+MNN_TEMPLATE
+void MNN_FEEDFORWARD::getMemoryUsage(MemoryUsage& usage) const
+{
+    usage.parameters += (weight_.size() + bias_.size()) * sizeof(Float);
+    usage.state += optimizer_->stateBytes();
+    // views are counted by the owner
+    if (!input_.isView())
+        usage.activations += input_.size() * sizeof(Float);
+    if (!output_.isView())
+        usage.activations += output_.size() * sizeof(Float);
+    usage.scratch += (errorDer_.size() + reconInput_.size() + reconError_.size()
+                      + reconOutput_.size() + reconGradient_.size()) * sizeof(Float);
+}
+
 MNN_TEMPLATE
 void MNN_FEEDFORWARD::info(std::ostream &out, const std::string& pf) const
 {
@@ -383,13 +516,16 @@ void MNN_FEEDFORWARD::info(std::ostream &out, const std::string& pf) const
         << "\n" << pf << "learnrate  : " << learnRate_;
     if (doBias_)
         out << " (bias: " << learnRateBias_ << ")";
-    out << "\n" << pf << "momentum   : " << momentum_
-        << "\n" << pf << "activation : " << ActFunc::static_name();
+    out << "\n" << pf << "momentum   : " << momentum()
+        << "\n" << pf << "optimizer  : ";
+    optimizer_->info(out);
+    out << "\n" << pf << "activation : " << ActFunc::static_name();
     if (doSoftmax_)
         out << " (softmax)";
     out << "\n" << pf << "inputs     : " << numIn()
         << "\n" << pf << "outputs    : " << numOut()
         << "\n" << pf << "parameters : " << numParameters()
+        << "\n" << pf << "memory     : " << this->memoryUsage()
         << std::endl;
 }
 
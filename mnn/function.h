@@ -12,6 +12,8 @@
 #include <cinttypes>
 #include <cmath>
 
+#include "random.h"
+
 namespace MNN {
 
 
@@ -37,7 +39,7 @@ namespace Private {
 template <typename Float>
 typename Private::IsFloat<Float>::Type rnd(Float min_, Float max_)
 {
-	return min_ + (Float)rand()/RAND_MAX * (max_ - min_);
+	return Random::local().uniform(min_, max_);
 }
 
 template <typename Float>
@@ -104,24 +106,121 @@ struct DenseMatrix
         }
     }
 
+    /** Number of vectors that the batch functions process
+        per sweep over the weights, to keep them in cache */
+    static const size_t batchBlockSize = 16;
+
+    /** Forward propagate @p num vectors of @p input into
+        @p num vectors of @p output, same as fprop() for each vector.
+        Each weight row is used for a block of vectors before moving on. */
+    template <typename Float, class Activation>
+    static void fprop_batch(
+            const Float* input, Float* output, const Float* weight,
+            size_t numIn, size_t numOut, size_t num)
+    {
+        fprop_bias_batch<Float, Activation>(
+                    input, output, nullptr, weight, numIn, numOut, num);
+    }
+
+    /** Same as fprop_bias() for @p num vectors of @p input and @p output,
+        or fprop() if @p bias is NULL.
+        Each weight row is used for a block of vectors before moving on. */
+    template <typename Float, class Activation>
+    static void fprop_bias_batch(
+            const Float* input, Float* output, const Float* bias,
+            const Float* weight,
+            size_t numIn, size_t numOut, size_t num)
+    {
+        for (size_t b0 = 0; b0 < num; b0 += batchBlockSize)
+        {
+            const size_t b1 = std::min(num, b0 + batchBlockSize);
+            const Float* w = weight;
+            for (size_t o = 0; o < numOut; ++o, w += numIn)
+            {
+                const Float start = bias ? bias[o] : Float(0);
+                size_t b = b0;
+                // four independent sums at once
+                for (; b + 4 <= b1; b += 4)
+                {
+                    const Float *v0 = input + b * numIn, *v1 = v0 + numIn,
+                                *v2 = v1 + numIn, *v3 = v2 + numIn;
+                    Float s0 = start, s1 = start, s2 = start, s3 = start;
+                    for (size_t i = 0; i < numIn; ++i)
+                    {
+                        s0 += v0[i] * w[i];
+                        s1 += v1[i] * w[i];
+                        s2 += v2[i] * w[i];
+                        s3 += v3[i] * w[i];
+                    }
+                    output[b * numOut + o] = Activation::activation(s0);
+                    output[(b + 1) * numOut + o] = Activation::activation(s1);
+                    output[(b + 2) * numOut + o] = Activation::activation(s2);
+                    output[(b + 3) * numOut + o] = Activation::activation(s3);
+                }
+                for (; b < b1; ++b)
+                {
+                    const Float* inp = input + b * numIn;
+                    Float sum = start;
+                    for (size_t i = 0; i < numIn; ++i)
+                        sum += inp[i] * w[i];
+
+                    output[b * numOut + o] = Activation::activation(sum);
+                }
+            }
+        }
+    }
+
     /** Forward propagate @p input into @p output
-        using transposed weight matrix. */
+        using transposed weight matrix.
+        The weights are read row by row, in memory order. */
     template <typename Float, class Activation>
     static void fprop_transpose(
             const Float* input, Float* output, const Float* weight,
             size_t numIn, size_t numOut)
     {
-        for (size_t o = 0; o < numOut; ++o, ++output)
+        for (size_t o = 0; o < numOut; ++o)
+            output[o] = Float(0);
+
+        for (size_t i = 0; i < numIn; ++i, weight += numOut)
         {
-            Float sum = 0;
-            const Float* inp = input;
-            for (auto i = 0; i < numIn; ++i, ++inp)
+            const Float inp = input[i];
+            for (size_t o = 0; o < numOut; ++o)
+                output[o] += inp * weight[o];
+        }
+
+        for (size_t o = 0; o < numOut; ++o)
+            output[o] = Activation::activation(output[o]);
+    }
+
+    /** Same as fprop_transpose() for @p num vectors of @p input
+        and @p output. Each weight row is used for a block of
+        vectors before moving on. */
+    template <typename Float, class Activation>
+    static void fprop_transpose_batch(
+            const Float* input, Float* output, const Float* weight,
+            size_t numIn, size_t numOut, size_t num)
+    {
+        for (size_t k = 0; k < num * numOut; ++k)
+            output[k] = Float(0);
+
+        for (size_t b0 = 0; b0 < num; b0 += batchBlockSize)
+        {
+            const size_t b1 = std::min(num, b0 + batchBlockSize);
+            const Float* w = weight;
+            for (size_t i = 0; i < numIn; ++i, w += numOut)
             {
-                sum += *inp * weight[i * numOut + o];
+                for (size_t b = b0; b < b1; ++b)
+                {
+                    const Float inp = input[b * numIn + i];
+                    Float* outp = output + b * numOut;
+                    for (size_t o = 0; o < numOut; ++o)
+                        outp[o] += inp * w[o];
+                }
             }
-
-            *output = Activation::activation(sum);
         }
+
+        for (size_t k = 0; k < num * numOut; ++k)
+            output[k] = Activation::activation(output[k]);
     }
 
     /** Forward propagate @p input into @p output
@@ -144,39 +243,31 @@ struct DenseMatrix
         }
     }
 
-    /** Propagates values from @p output into @p input */
+    /** Propagates values from @p output into @p input.
+        The weights are read row by row, in memory order. */
     template <typename Float>
     static void bprop(
             Float* input, const Float* output, const Float* weight,
             size_t numIn, size_t numOut)
     {
-        for (size_t i = 0; i < numIn; ++i, ++input)
-        {
-            Float sum = 0;
-            const Float* outp = output;
-            for (size_t o = 0; o < numOut; ++o, ++outp)
-            {
-                sum += *outp * weight[o * numIn + i];
-            }
-            *input = sum;
-        }
+        bprop_stride(input, output, weight, numIn, numOut, numIn);
     }
 
-    /** Propagates values from @p output into @p input */
+    /** Propagates values from @p output into the first @p numIn
+        values of @p input, for weight rows of length @p numInStride */
     template <typename Float>
     static void bprop_stride(
             Float* input, const Float* output, const Float* weight,
             size_t numIn, size_t numOut, size_t numInStride)
     {
-        for (size_t i = 0; i < numIn; ++i, ++input)
+        for (size_t i = 0; i < numIn; ++i)
+            input[i] = Float(0);
+
+        for (size_t o = 0; o < numOut; ++o, weight += numInStride)
         {
-            Float sum = 0;
-            const Float* outp = output;
-            for (size_t o = 0; o < numOut; ++o, ++outp)
-            {
-                sum += *outp * weight[o * numInStride + i];
-            }
-            *input = sum;
+            const Float outp = output[o];
+            for (size_t i = 0; i < numIn; ++i)
+                input[i] += outp * weight[i];
         }
     }
 
@@ -438,6 +529,43 @@ struct ConvolutionMatrix
         }
     }
 
+    /** Calculates the gradient of the convolution filter.
+        @param input is the @p inputWidth * @p inputHeight input map
+        @param errorDerivative is the partial derivative of the produced error
+               with size ((@p inputWidth - @p kernelWidth) / @p strideX + 1)
+                       * ((@p inputHeight - @p kernelHeight) / @p strideY + 1)
+        @param gradient has size @p kernelWidth * @p kernelHeight
+               and receives the summed weight deltas.
+    */
+    template <typename Float>
+    static void gradient(
+                const Float* input, const Float* errorDerivative,
+                Float* gradient,
+                size_t inputWidth, size_t inputHeight,
+                size_t kernelWidth, size_t kernelHeight,
+                size_t strideX, size_t strideY)
+    {
+        const size_t
+                scanWidth = (inputWidth - kernelWidth + 1),
+                scanHeight = (inputHeight - kernelHeight + 1),
+                kernelSize = kernelWidth * kernelHeight;
+
+        for (size_t i=0; i<kernelSize; ++i)
+            gradient[i] = Float(0);
+
+        for (size_t sy = 0; sy < scanHeight; sy += strideY)
+        for (size_t sx = 0; sx < scanWidth; sx += strideX, ++errorDerivative)
+        {
+            Float *w = gradient;
+            for (size_t iy = 0; iy < kernelHeight; ++iy)
+            {
+                const Float* inp = &input[(sy + iy) * inputWidth + sx];
+                for (size_t ix = 0; ix < kernelWidth; ++ix, ++w, ++inp)
+                    *w += *errorDerivative * *inp;
+            }
+        }
+    }
+
     /** Gradient descent on convolution filter.
         @param input is the @p inputWidth * @p inputHeight input map
         @param errorDerivative is the partial derivative of the produced error
@@ -0,0 +1,103 @@
+/** @file inference.h
+
+    @brief Per-thread context for concurrent forward evaluation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_INFERENCE_H
+#define MNNSRC_INFERENCE_H
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+
+#include "layer.h"
+#include "workspace.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** All mutable state needed to run one network forward.
+
+    The network is held as a std::shared_ptr<const Layer> and only
+    used through Layer::infer(), which does not change the layer.
+    Any number of threads can share the same network, each with
+    it's own InferenceContext:
+
+    @code
+    std::shared_ptr<const Layer<float>> net(trainedNet.getCopy());
+
+    // in each worker thread
+    InferenceContext<float> ctx(net);
+    const float* out = ctx.fprop(input);
+    @endcode
+
+    A context is not thread-safe itself. After construction,
+    fprop() does not allocate memory.
+*/
+template <typename Float>
+class InferenceContext
+{
+public:
+
+    /** Creates an empty context, setNetwork() must be called before fprop() */
+    InferenceContext() { }
+
+    explicit InferenceContext(std::shared_ptr<const Layer<Float>> net)
+        { setNetwork(net); }
+
+    // ------------ getter ---------------
+
+    /** The shared network, may be NULL */
+    const std::shared_ptr<const Layer<Float>>& network() const { return net_; }
+
+    size_t numIn() const { return net_ ? net_->numIn() : 0; }
+    size_t numOut() const { return output_.size(); }
+
+    /** Output of the last fprop(input) */
+    const Float* output() const { return output_.data(); }
+
+    // ------------ setter ---------------
+
+    /** Replaces the network, e.g. with a newer snapshot of a trained net.
+        The buffers are only reallocated if they are too small. */
+    void setNetwork(std::shared_ptr<const Layer<Float>> net)
+    {
+        net_ = net;
+        if (!net_)
+            return;
+        workspace_.reserve(net_->workspaceSize());
+        output_.resize(net_->numOut());
+    }
+
+    // ------------ propagation ----------
+
+    /** Propagates numIn() values of @p input into numOut() values of @p output */
+    void fprop(const Float* input, Float* output)
+    {
+        if (!net_)
+            MNN_EXCEPTION("InferenceContext::fprop() without network");
+        net_->infer(input, output, workspace_);
+    }
+
+    /** Propagates @p input into the internal output(), which is returned */
+    const Float* fprop(const Float* input)
+    {
+        fprop(input, output_.data());
+        return output_.data();
+    }
+
+private:
+
+    std::shared_ptr<const Layer<Float>> net_;
+    Workspace<Float> workspace_;
+    std::vector<Float> output_;
+};
+
+} // namespace MNN
+
+#endif // MNNSRC_INFERENCE_H
@@ -164,6 +164,33 @@ public:
 
 
 
+// ---------------- optimizer ----------------
+
+template <typename Float>
+class Optimizer;
+
+/** Interface for setting the weight update rule */
+template <typename Float>
+class SetOptimizerInterface
+{
+public:
+
+    /** Uses a copy of @p opt for the weight updates.
+        The training state is reset. */
+    virtual void setOptimizer(const Optimizer<Float>& opt) = 0;
+};
+
+/** Interface for getting the weight update rule */
+template <typename Float>
+class GetOptimizerInterface
+{
+public:
+
+    virtual const Optimizer<Float>& optimizer() const = 0;
+};
+
+
+
 // ------------------- cd ------------------
 
 /** Contrastive divergence training. */
@@ -265,6 +292,13 @@ void setMomentum(Layer<Float>* l, Float v)
         d->setMomentum(v);
 }
 
+template <typename Float>
+void setOptimizer(Layer<Float>* l, const Optimizer<Float>& opt)
+{
+    if (auto d = dynamic_cast<SetOptimizerInterface<Float>*>(l))
+        d->setOptimizer(opt);
+}
+
 template <typename Float>
 void setSoftmax(Layer<Float>* l, bool enable)
 {
@@ -11,13 +11,74 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <memory>
 
 #include "function.h"
 #include "exception.h"
+#include "workspace.h"
+#include "buffer.h"
+#include "binary_io.h"
+#include "text_io.h"
 
 namespace MNN {
 
 
+/** Type of a ParameterBlock */
+enum ParameterType
+{
+    /** Adjustable parameters, e.g. weights or biases */
+    PT_PARAMETER,
+    /** Training state that belongs to the parameters, e.g. momentum */
+    PT_STATE
+};
+
+/** A continuous block of layer data.
+    Used for generic access to all parameters of a network */
+template <typename Float>
+struct ParameterBlock
+{
+    Float* data;
+    size_t size;
+    ParameterType type;
+    /** The Buffer holding the data, see ParameterArena */
+    Buffer<Float>* buffer;
+};
+
+
+/** Memory held by a layer in bytes, see Layer::getMemoryUsage() */
+struct MemoryUsage
+{
+    MemoryUsage() : parameters(0), state(0), activations(0), scratch(0) { }
+
+    /** Weights and biases */
+    size_t parameters;
+    /** Optimizer state */
+    size_t state;
+    /** Inputs and outputs */
+    size_t activations;
+    /** Temporary training data */
+    size_t scratch;
+
+    size_t total() const { return parameters + state + activations + scratch; }
+
+    MemoryUsage& operator += (const MemoryUsage& o)
+    {
+        parameters += o.parameters;
+        state += o.state;
+        activations += o.activations;
+        scratch += o.scratch;
+        return *this;
+    }
+};
+
+inline std::ostream& operator << (std::ostream& out, const MemoryUsage& m)
+{
+    out << m.total() << " bytes (parameters " << m.parameters
+        << ", state " << m.state << ", activations " << m.activations
+        << ", scratch " << m.scratch << ")";
+    return out;
+}
 
 
 /** NN-Layer base class (abstract).
@@ -35,6 +96,7 @@ namespace MNN {
     @li input() and output(), to return pointers to the arrays
     @li brainwash(), to reset the weights, coefficients or whathaveyou.
     @li fprop(), this should propagte an array of Float from the input to the output.
+    @li infer(), the same as fprop() but without changing the layer.
     @li bprop(), this should at least propagate the output back to the input.
         as with back-propagation kind of nets, this should use the error
         and adjust the internal weights, while passing the derivative through.
@@ -42,6 +104,7 @@ namespace MNN {
     @li info(), to print a human-readable overview over the settings.
     @li dump(), to print (possibly much) internal data to some std::ostream.
     @li serialize() and deserialize(), to save and load from ascii data
+    @li serializeBinary() and deserializeBinary(), the same in the binary format
 	</p>
 
     <p>Each derived class should be copyable
@@ -49,7 +112,9 @@ namespace MNN {
 
     <p>The (de)serialization from/to text is choosen so that
     different Float template parameter or endianess do not
-    cause problems for file persistence.</p>
+    cause problems for file persistence. The binary format is
+    always little-endian and converts between float and double,
+    see BinaryWriter.</p>
 
  */
 template <typename Float>
@@ -72,8 +137,9 @@ class Layer
         No deep copy */
     virtual Layer<Float>* cloneClass() const = 0;
 
-    /** Returns a new instance with everything deep-copied
-        (using operator=) */
+    /** Returns a new instance with everything copied (using operator=).
+        Parameter Buffers are shared copy-on-write, so the copy is cheap
+        and independent of later changes to this layer. */
     virtual Layer<Float>* getCopy() const { auto l = cloneClass(); *l = *this; return l; }
 
     /** Deep-copy the given layer into this class.
@@ -123,12 +189,75 @@ class Layer
     virtual void setWeight(size_t input, size_t output, Float w)
         { weights()[output * numIn() + input] = w; }
 
+    /** Lets the layer keep it's input values in external memory,
+        e.g. the output of the previous layer in a StackSerial.
+        @p data holds numIn() Floats and stays valid while @p owner
+        is referenced. fprop() skips copying the input
+        when called with @p data.
+        Returns false if the layer does not support this. */
+    virtual bool setInputStorage(Float* /*data*/, const std::shared_ptr<void>& /*owner*/)
+        { return false; }
+
+    /** Same as setInputStorage() for the numOut() output values */
+    virtual bool setOutputStorage(Float* /*data*/, const std::shared_ptr<void>& /*owner*/)
+        { return false; }
+
+    /** Moves inputs and outputs back into memory of the layer */
+    virtual void detachStorage() { }
+
+    /** Appends all continuous blocks of parameters and training state
+        to @p blocks. Stacks append the blocks of all sub-layers in order.
+        The pointers are valid until the layer is resized. */
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks) = 0;
+
+    // ---- memory ------------
+
+    /** Enables lean mode for the layer and all sub-layers.
+        Training state (see Optimizer::setLean()) and other data only
+        needed for training is allocated by the first training step
+        that uses it. */
+    virtual void setLean(bool lean) = 0;
+
+    /** Frees the training state, e.g. of a frozen layer.
+        It is allocated again, set to zero, by the next training step. */
+    virtual void releaseTrainingState() = 0;
+
     // ---- propagation -------
 
     /** Forward propagate.
         Transmit the data in @p input to @p output. */
     virtual void fprop(const Float * input, Float * output) = 0;
 
+    /** Forward propagate for inference only.
+        Reads @p input and writes @p output without changing any
+        state of the layer, so one network can be used by many threads
+        at once, each with it's own @p workspace.
+        inputs() and outputs() are not updated and drop-out, if any,
+        is applied as in DO_PERFORM mode.
+        @p workspace must provide at least workspaceSize() Floats.
+        See InferenceContext for a convenient per-thread wrapper. */
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const = 0;
+
+    /** Number of Floats needed in the Workspace for infer() */
+    virtual size_t workspaceSize() const { return 0; }
+
+    /** Same as infer() for @p num vectors, one after another
+        in @p input and @p output.
+        Layers with a dense weight matrix use each weight for a block
+        of vectors, see DenseMatrix::fprop_batch(), the others
+        call infer() for each vector.
+        @p workspace must provide at least workspaceSizeBatch(num) Floats. */
+    virtual void inferBatch(const Float * input, Float * output, size_t num,
+                            Workspace<Float>& workspace) const
+    {
+        for (size_t i = 0; i < num; ++i, input += numIn(), output += numOut())
+            infer(input, output, workspace);
+    }
+
+    /** Number of Floats needed in the Workspace for inferBatch() of @p num vectors */
+    virtual size_t workspaceSizeBatch(size_t num) const { (void)num; return workspaceSize(); }
+
     /** Backward propagate the error derivative, and adjust weights.
         Transmit data in @p error to @p error_output, if not NULL.
         Perform weight update if @p global_learn_rate != 0.
@@ -149,6 +278,13 @@ class Layer
         typically the number of weights */
     virtual size_t numParameters() const = 0;
 
+    /** Adds the memory held by the layer, and all sub-layers,
+        to @p usage */
+    virtual void getMemoryUsage(MemoryUsage& usage) const = 0;
+
+    /** Returns the memory held by the layer */
+    MemoryUsage memoryUsage() const { MemoryUsage m; getMemoryUsage(m); return m; }
+
     /** Print an overview of the network */
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const = 0;
@@ -179,6 +315,28 @@ class Layer
         @throws MNN::Exception on error */
     virtual void deserialize(std::istream&) = 0;
 
+    /** Saves the layer to a file using serializeBinary().
+        @throws MNN::Exception */
+    void saveBinaryFile(const std::string& filename) const;
+
+    /** Loads the layer from a file using deserializeBinary().
+        @throws MNN::Exception */
+    void loadBinaryFile(const std::string& filename);
+
+    /** Loads the layer from a binary or text file,
+        depending on the contents.
+        @throws MNN::Exception */
+    void loadFile(const std::string& filename);
+
+    /** Writes the same data as serialize() as one record
+        of the binary model format, see BinaryWriter.
+        The values are stored as raw, aligned blocks. */
+    virtual void serializeBinary(BinaryWriter&) const = 0;
+
+    /** Reads a record written by serializeBinary().
+        @throws MNN::Exception on error */
+    virtual void deserializeBinary(BinaryReader&) = 0;
+
 };
 
 // ------------------------ impl ---------------------------
@@ -206,6 +364,35 @@ void Layer<Float>::loadTextFile(const std::string& filename)
     fs.close();
 }
 
+template <typename Float>
+void Layer<Float>::saveBinaryFile(const std::string& filename) const
+{
+    BinaryWriter w;
+    w.writeHeader();
+    serializeBinary(w);
+    w.saveFile(filename);
+}
+
+
+template <typename Float>
+void Layer<Float>::loadBinaryFile(const std::string& filename)
+{
+    BinaryReader r;
+    r.readFile(filename);
+    r.readHeader();
+    deserializeBinary(r);
+}
+
+
+template <typename Float>
+void Layer<Float>::loadFile(const std::string& filename)
+{
+    if (Binary::isBinaryFile(filename))
+        loadBinaryFile(filename);
+    else
+        loadTextFile(filename);
+}
+
 } // namespace MNN
 
 #endif // MNNSRC_LAYER_H_INCLUDED
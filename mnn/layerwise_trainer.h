@@ -0,0 +1,210 @@
+/** @file layerwise_trainer.h
+
+    @brief Overlapped greedy layer-wise pretraining
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_LAYERWISE_TRAINER_H
+#define MNNSRC_LAYERWISE_TRAINER_H
+
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+#include "layer.h"
+#include "workspace.h"
+#include "random.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** Progress of one layer in LayerwiseTrainer */
+struct LayerwiseStats
+{
+    LayerwiseStats() : numSteps(0), numSnapshots(0), numRefreshes(0),
+                       errorSum(0.), errorCount(0) { }
+
+    /** Average error since the last report */
+    double averageError() const { return errorCount ? errorSum / errorCount : 0.; }
+
+    size_t numSteps,
+    /** Number of snapshots published for the layer above */
+           numSnapshots,
+    /** Number of times the snapshots of the layers below were renewed */
+           numRefreshes;
+    double errorSum;
+    size_t errorCount;
+};
+
+
+/** Unsupervised greedy layer-wise training of a stack of layers,
+    e.g. RBMs or autoencoders.
+
+    Each layer trains on it's own thread. Layer k takes it's input
+    from the samples, propagated through snapshots of the layers
+    0 to k-1. Every snapshotInterval() steps each layer publishes
+    a new snapshot (a Layer::getCopy(), which shares the weights until
+    the next update) and every refreshInterval() steps a layer picks
+    up the newest snapshots of the layers below.
+
+    In overlapped mode layer k+1 starts as soon as layer k has made
+    startDelay() steps, so the total time approaches that of the
+    slowest layer instead of the sum of all layers. Without overlap
+    each layer starts when the one below has finished, which is the
+    classic greedy scheme.
+
+    Each layer can end early through a DoneFunc, e.g. when its
+    weights stop changing, but only once the layers below have
+    finished, since its input changes until then.
+
+    The layers are trained concurrently, so they must not share
+    their inputs or outputs, e.g. through a StackSerial with
+    StackSerial::shareActivations(). addLayer() and run() call
+    Layer::detachStorage() of each layer. A stack holding the layers
+    must not be changed while run() is active.
+
+    @code
+    LayerwiseTrainer<float> t;
+    t.setSamples(set.numSamples(), [&](size_t i) { return set.image(i); });
+    for (auto rbm : rbms)
+        t.addLayer(rbm, 100000, [](Layer<float>& l, const float* in, size_t num)
+        {
+            return static_cast<Rbm<float>&>(l).contrastiveDivergenceBatch(in, num);
+        });
+    t.run();
+    @endcode
+*/
+template <typename Float>
+class LayerwiseTrainer
+{
+    LayerwiseTrainer(const LayerwiseTrainer&) = delete;
+    void operator = (const LayerwiseTrainer&) = delete;
+
+public:
+
+    /** Trains @p layer on @p batchSize input vectors, one after another
+        in @p input. Returns the error. */
+    typedef std::function<Float(Layer<Float>& layer, const Float* input, size_t batchSize)>
+            TrainFunc;
+
+    /** Returns the sample at index. Must be callable from several threads. */
+    typedef std::function<const Float*(size_t index)> SampleFunc;
+
+    /** Called from the worker threads every reportInterval() steps of a layer.
+        The calls are serialized. */
+    typedef std::function<void(size_t layerIndex, const LayerwiseStats&)> ReportFunc;
+
+    /** Called from the layer's thread every snapshotInterval() steps,
+        once all layers below have finished.
+        Returns true when the layer is trained enough. */
+    typedef std::function<bool(const Layer<Float>& layer, const LayerwiseStats&)> DoneFunc;
+
+    /** Called from the layer's thread when layer @p layerIndex has finished,
+        e.g. to save it. Not called after stop().
+        The calls are serialized with each other and the ReportFunc. */
+    typedef std::function<void(size_t layerIndex, const Layer<Float>& layer)> FinishedFunc;
+
+    LayerwiseTrainer();
+
+    // ------------ settings -------------
+
+    void setSamples(size_t num, SampleFunc func) { numSamples_ = num; sampleFunc_ = func; }
+
+    /** Adds @p layer on top of the stack, which trains for at most
+        @p numSteps batches with @p train, or until @p done returns true.
+        The layer is not owned. */
+    void addLayer(Layer<Float>* layer, size_t numSteps, TrainFunc train,
+                  DoneFunc done = DoneFunc());
+
+    void setOverlapped(bool enable) { overlapped_ = enable; }
+    /** Number of samples per call to the TrainFunc */
+    void setBatchSize(size_t num) { batchSize_ = std::max(size_t(1), num); }
+    /** Steps of a layer between publishing snapshots */
+    void setSnapshotInterval(size_t steps) { snapshotInterval_ = std::max(size_t(1), steps); }
+    /** Steps of a layer between picking up the snapshots of the layers below */
+    void setRefreshInterval(size_t steps) { refreshInterval_ = std::max(size_t(1), steps); }
+    /** Steps of a layer before the layer above starts in overlapped mode */
+    void setStartDelay(size_t steps) { startDelay_ = steps; }
+    void setReportFunc(ReportFunc f) { reportFunc_ = f; }
+    void setFinishedFunc(FinishedFunc f) { finishedFunc_ = f; }
+    /** Report every @p steps steps of a layer, 0 = never */
+    void setReportInterval(size_t steps) { reportInterval_ = steps; }
+
+    // ------------ getter ---------------
+
+    size_t numLayers() const { return layers_.size(); }
+    bool isOverlapped() const { return overlapped_; }
+    size_t batchSize() const { return batchSize_; }
+    size_t snapshotInterval() const { return snapshotInterval_; }
+    size_t refreshInterval() const { return refreshInterval_; }
+    size_t startDelay() const { return startDelay_; }
+    size_t reportInterval() const { return reportInterval_; }
+
+    /** Steps made by layer @p index so far, thread-safe */
+    size_t numSteps(size_t index) const { return layers_[index]->step.load(); }
+
+    // ------------ training -------------
+
+    /** Trains all layers, one thread per layer, and blocks until
+        all are finished or stop() was called.
+        The first exception of a worker is rethrown. */
+    void run();
+
+    /** Asks the workers to finish after their current step.
+        Can be called from any thread. */
+    void stop() { doStop_ = true; wakeAll_(); }
+
+private:
+
+    struct LayerData
+    {
+        Layer<Float>* layer;
+        size_t numSteps;
+        TrainFunc train;
+        DoneFunc done;
+        std::atomic<size_t> step;
+        bool finished;
+        std::shared_ptr<const Layer<Float>> snapshot;
+        LayerwiseStats stats;
+    };
+
+    void work_(size_t index);
+    void publish_(size_t index);
+    /** Waits until layer @p index may start, returns false on stop */
+    bool waitForStart_(size_t index);
+    /** Returns true if all layers below @p index have finished */
+    bool belowFinished_(size_t index);
+    void wakeAll_();
+
+    std::vector<std::unique_ptr<LayerData>> layers_;
+    size_t numSamples_;
+    SampleFunc sampleFunc_;
+    ReportFunc reportFunc_;
+    FinishedFunc finishedFunc_;
+
+    bool overlapped_;
+    size_t batchSize_, snapshotInterval_, refreshInterval_,
+           startDelay_, reportInterval_;
+
+    std::mutex mutex_, reportMutex_;
+    std::condition_variable cond_;
+    std::atomic<bool> doStop_;
+    std::exception_ptr error_;
+};
+
+#include "layerwise_trainer_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_LAYERWISE_TRAINER_H
@@ -0,0 +1,248 @@
+/** @file layerwise_trainer_impl.inl
+
+    @brief LayerwiseTrainer implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_LAYERWISE LayerwiseTrainer<Float>
+
+MNN_TEMPLATE
+MNN_LAYERWISE::LayerwiseTrainer()
+    : numSamples_       (0)
+    , overlapped_       (true)
+    , batchSize_        (1)
+    , snapshotInterval_ (1000)
+    , refreshInterval_  (1000)
+    , startDelay_       (1000)
+    , reportInterval_   (0)
+    , doStop_           (false)
+{
+}
+
+MNN_TEMPLATE
+void MNN_LAYERWISE::addLayer(Layer<Float>* layer, size_t numSteps, TrainFunc train,
+                             DoneFunc done)
+{
+    if (!layers_.empty() && layers_.back()->layer->numOut() != layer->numIn())
+        MNN_EXCEPTION("Layer " << layers_.size() << " of LayerwiseTrainer expects "
+                      << layer->numIn() << " inputs, previous layer has "
+                      << layers_.back()->layer->numOut() << " outputs");
+
+    // each layer is trained on its own thread
+    layer->detachStorage();
+
+    auto d = new LayerData;
+    d->layer = layer;
+    d->numSteps = numSteps;
+    d->train = train;
+    d->done = done;
+    d->step = 0;
+    d->finished = false;
+    layers_.push_back(std::unique_ptr<LayerData>(d));
+}
+
+MNN_TEMPLATE
+void MNN_LAYERWISE::run()
+{
+    if (layers_.empty())
+        return;
+    if (numSamples_ == 0 || !sampleFunc_)
+        MNN_EXCEPTION("LayerwiseTrainer::run() without samples");
+
+    doStop_ = false;
+    error_ = nullptr;
+    for (auto& d : layers_)
+    {
+        // a stack may have bound them again since addLayer()
+        d->layer->detachStorage();
+        d->step = 0;
+        d->finished = false;
+        d->snapshot.reset();
+        d->stats = LayerwiseStats();
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < layers_.size(); ++i)
+        threads.push_back(std::thread([this, i]()
+        {
+            try
+            {
+                work_(i);
+            }
+            catch (...)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (!error_)
+                        error_ = std::current_exception();
+                    layers_[i]->finished = true;
+                }
+                stop();
+            }
+        }));
+
+    for (auto& t : threads)
+        t.join();
+
+    // the snapshots are not needed anymore
+    for (auto& d : layers_)
+        d->snapshot.reset();
+
+    if (error_)
+        std::rethrow_exception(error_);
+}
+
+MNN_TEMPLATE
+void MNN_LAYERWISE::wakeAll_()
+{
+    // lock, so no worker misses the notification between check and wait
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.notify_all();
+}
+
+MNN_TEMPLATE
+bool MNN_LAYERWISE::waitForStart_(size_t index)
+{
+    if (index == 0)
+        return !doStop_;
+
+    const LayerData& below = *layers_[index - 1];
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&]()
+    {
+        return doStop_ || below.finished
+            || (overlapped_ && below.snapshot && below.step >= startDelay_);
+    });
+    return !doStop_;
+}
+
+MNN_TEMPLATE
+bool MNN_LAYERWISE::belowFinished_(size_t index)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < index; ++i)
+        if (!layers_[i]->finished)
+            return false;
+    return true;
+}
+
+MNN_TEMPLATE
+void MNN_LAYERWISE::publish_(size_t index)
+{
+    LayerData& d = *layers_[index];
+    // copy on the training thread, the weights are shared until the next update
+    std::shared_ptr<const Layer<Float>> snapshot(d.layer->getCopy());
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        d.snapshot.swap(snapshot);
+        ++d.stats.numSnapshots;
+    }
+    cond_.notify_all();
+    // the previous snapshot is released outside the lock
+}
+
+MNN_TEMPLATE
+void MNN_LAYERWISE::work_(size_t index)
+{
+    LayerData& d = *layers_[index];
+    if (!waitForStart_(index))
+        return;
+
+    // scratch space for propagating through the layers below
+    size_t maxWidth = 0, maxLayer = 0;
+    for (size_t i = 0; i < index; ++i)
+    {
+        if (i + 1 < index)
+            maxWidth = std::max(maxWidth, layers_[i]->layer->numOut());
+        maxLayer = std::max(maxLayer, layers_[i]->layer->workspaceSize());
+    }
+    Workspace<Float> workspace(2 * maxWidth + maxLayer);
+    Float * cur = workspace.allocate(maxWidth),
+          * next = workspace.allocate(maxWidth);
+
+    const size_t numIn = d.layer->numIn();
+    std::vector<Float> batch(batchSize_ * numIn);
+    std::vector<std::shared_ptr<const Layer<Float>>> below(index);
+
+    for (size_t step = 0; step < d.numSteps && !doStop_; ++step)
+    {
+        if (index > 0 && step % refreshInterval_ == 0)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < index; ++i)
+                below[i] = layers_[i]->snapshot;
+            ++d.stats.numRefreshes;
+        }
+
+        // random samples, through the snapshots of the layers below
+        for (size_t b = 0; b < batchSize_; ++b)
+        {
+            const Float* input = sampleFunc_(Random::local().index(numSamples_));
+            Float* dst = &batch[b * numIn];
+            if (index == 0)
+            {
+                std::copy(input, input + numIn, dst);
+                continue;
+            }
+            if (index == 1)
+            {
+                below[0]->infer(input, dst, workspace);
+                continue;
+            }
+            Float * c = cur, * n = next;
+            below[0]->infer(input, c, workspace);
+            for (size_t i = 1; i + 1 < index; ++i)
+            {
+                below[i]->infer(c, n, workspace);
+                std::swap(c, n);
+            }
+            below[index - 1]->infer(c, dst, workspace);
+        }
+
+        const Float err = d.train(*d.layer, &batch[0], batchSize_);
+        d.stats.errorSum += err;
+        ++d.stats.errorCount;
+        d.stats.numSteps = step + 1;
+        d.step = step + 1;
+
+        bool done = false;
+        if ((step + 1) % snapshotInterval_ == 0)
+        {
+            publish_(index);
+            done = d.done && belowFinished_(index) && d.done(*d.layer, d.stats);
+        }
+
+        if (reportFunc_ && reportInterval_ && (step + 1) % reportInterval_ == 0)
+        {
+            std::unique_lock<std::mutex> lock(reportMutex_);
+            reportFunc_(index, d.stats);
+            d.stats.errorSum = 0.;
+            d.stats.errorCount = 0;
+        }
+
+        if (done)
+            break;
+    }
+
+    publish_(index);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        d.finished = true;
+    }
+    cond_.notify_all();
+
+    if (finishedFunc_ && !doStop_)
+    {
+        std::unique_lock<std::mutex> lock(reportMutex_);
+        finishedFunc_(index, *d.layer);
+    }
+}
+
+#undef MNN_TEMPLATE
+#undef MNN_LAYERWISE
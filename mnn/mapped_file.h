@@ -0,0 +1,184 @@
+/** @file mapped_file.h
+
+    @brief Memory-mapped file
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_MAPPED_FILE_H
+#define MNNSRC_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define MNN_HAVE_MMAP
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#include "exception.h"
+
+namespace MNN {
+
+/** A file mapped into memory.
+
+    The mapping is page-aligned and stays valid until close()
+    or destruction. Read-only mappings of the same file are
+    shared between processes through the page cache.
+
+    Only available on POSIX systems, elsewhere
+    open() and create() throw.
+*/
+class MappedFile
+{
+    MappedFile(const MappedFile&) = delete;
+    void operator = (const MappedFile&) = delete;
+
+public:
+
+    MappedFile() : data_(nullptr), size_(0), writeable_(false) { }
+    ~MappedFile() { close(); }
+
+    /** Maps an existing file read-only */
+    void open(const std::string& filename);
+
+    /** Creates or truncates a file of @p size bytes
+        and maps it for reading and writing */
+    void create(const std::string& filename, size_t size);
+
+    /** Unmaps the file */
+    void close();
+
+    void swap(MappedFile& other)
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(writeable_, other.writeable_);
+        filename_.swap(other.filename_);
+    }
+
+    bool isOpen() const { return data_ != nullptr; }
+    bool isWriteable() const { return writeable_; }
+
+    const std::string& filename() const { return filename_; }
+
+    /** Size in bytes */
+    size_t size() const { return size_; }
+
+    const char* data() const { return static_cast<const char*>(data_); }
+    char* data() { return writeable_ ? static_cast<char*>(data_) : nullptr; }
+
+private:
+
+    void map_(int fd, size_t size, bool writeable);
+
+    void* data_;
+    size_t size_;
+    bool writeable_;
+    std::string filename_;
+};
+
+
+// ------------------ impl ------------------
+
+#ifdef MNN_HAVE_MMAP
+
+inline void MappedFile::open(const std::string& filename)
+{
+    close();
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        MNN_EXCEPTION("Could not open '" << filename << "' for mapping");
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        MNN_EXCEPTION("Could not stat '" << filename << "'");
+    }
+    filename_ = filename;
+    map_(fd, size_t(st.st_size), false);
+}
+
+inline void MappedFile::create(const std::string& filename, size_t size)
+{
+    close();
+    const int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        MNN_EXCEPTION("Could not create '" << filename << "' for mapping");
+    if (::ftruncate(fd, off_t(size)) != 0)
+    {
+        ::close(fd);
+        MNN_EXCEPTION("Could not resize '" << filename << "' to " << size << " bytes");
+    }
+    filename_ = filename;
+    map_(fd, size, true);
+}
+
+inline void MappedFile::map_(int fd, size_t size, bool writeable)
+{
+    size_ = size;
+    writeable_ = writeable;
+    // mmap() refuses empty files
+    if (size == 0)
+    {
+        ::close(fd);
+        static char empty = 0;
+        data_ = &empty;
+        return;
+    }
+    void* p = ::mmap(nullptr, size, writeable ? PROT_READ | PROT_WRITE : PROT_READ,
+                     MAP_SHARED, fd, 0);
+    // the mapping keeps the file
+    ::close(fd);
+    if (p == MAP_FAILED)
+    {
+        size_ = 0;
+        MNN_EXCEPTION("Could not map '" << filename_ << "'");
+    }
+    data_ = p;
+}
+
+inline void MappedFile::close()
+{
+    if (data_ && size_)
+        ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    writeable_ = false;
+    filename_.clear();
+}
+
+#else
+
+inline void MappedFile::open(const std::string& filename)
+{
+    MNN_EXCEPTION("Memory-mapping of '" << filename << "' not supported on this system");
+}
+
+inline void MappedFile::create(const std::string& filename, size_t)
+{
+    MNN_EXCEPTION("Memory-mapping of '" << filename << "' not supported on this system");
+}
+
+inline void MappedFile::map_(int, size_t, bool) { }
+
+inline void MappedFile::close()
+{
+    data_ = nullptr;
+    size_ = 0;
+    writeable_ = false;
+    filename_.clear();
+}
+
+#endif
+
+} // namespace MNN
+
+#endif // MNNSRC_MAPPED_FILE_H
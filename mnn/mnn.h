@@ -9,14 +9,31 @@
 #define MNNSRC_MNN_H_INCLUDED
 
 #include "mnn/activation.h"
+#include "mnn/random.h"
 #include "mnn/function.h"
 #include "mnn/interface.h"
+#include "mnn/workspace.h"
+#include "mnn/buffer.h"
+#include "mnn/binary_io.h"
+#include "mnn/text_io.h"
 #include "mnn/layer.h"
+#include "mnn/optimizer.h"
 #include "mnn/stack_serial.h"
 #include "mnn/stack_parallel.h"
 #include "mnn/feedforward.h"
 #include "mnn/convolution.h"
 #include "mnn/rbm.h"
+#include "mnn/parameter_arena.h"
+#include "mnn/model_averaging.h"
+#include "mnn/pipeline.h"
+#include "mnn/allocation_counter.h"
+#include "mnn/trainer.h"
+#include "mnn/evaluator.h"
+#include "mnn/inference.h"
+#include "mnn/mapped_file.h"
+#include "mnn/feature_matrix.h"
+#include "mnn/layerwise_trainer.h"
+#include "mnn/checkpointer.h"
 
 namespace MNN {
 
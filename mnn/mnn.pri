@@ -4,7 +4,15 @@ SOURCES += \
     mnn/convolution_impl.inl \
     mnn/stack_parallel_impl.inl \
     mnn/feedforward_impl.inl \
-    $$PWD/factory_impl.inl
+    $$PWD/factory_impl.inl \
+    $$PWD/model_averaging_impl.inl \
+    $$PWD/pipeline_impl.inl \
+    $$PWD/optimizer_impl.inl \
+    $$PWD/trainer_impl.inl \
+    $$PWD/evaluator_impl.inl \
+    $$PWD/parameter_arena_impl.inl \
+    $$PWD/layerwise_trainer_impl.inl \
+    $$PWD/checkpointer_impl.inl
 
 HEADERS += \
     mnn/activation.h \
@@ -18,4 +26,23 @@ HEADERS += \
     mnn/stack_parallel.h \
     mnn/interface.h \
     mnn/feedforward.h \
-    $$PWD/factory.h
+    $$PWD/factory.h \
+    $$PWD/thread_pool.h \
+    $$PWD/model_averaging.h \
+    $$PWD/pipeline.h \
+    $$PWD/optimizer.h \
+    $$PWD/dataset.h \
+    $$PWD/trainer.h \
+    $$PWD/evaluator.h \
+    $$PWD/workspace.h \
+    $$PWD/buffer.h \
+    $$PWD/parameter_arena.h \
+    $$PWD/allocation_counter.h \
+    $$PWD/inference.h \
+    $$PWD/random.h \
+    $$PWD/mapped_file.h \
+    $$PWD/feature_matrix.h \
+    $$PWD/layerwise_trainer.h \
+    $$PWD/binary_io.h \
+    $$PWD/checkpointer.h \
+    $$PWD/text_io.h
@@ -0,0 +1,117 @@
+/** @file model_averaging.h
+
+    @brief Synchronous data-parallel training by averaging network replicas
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_MODEL_AVERAGING_H
+#define MNNSRC_MODEL_AVERAGING_H
+
+#include <vector>
+#include <functional>
+#include <memory>
+#include <algorithm>
+
+#include "layer.h"
+#include "thread_pool.h"
+#include "parameter_arena.h"
+
+namespace MNN {
+
+/** Synchronous data-parallel training by model averaging.
+
+    Keeps one replica of a network per thread (created with Layer::getCopy()).
+    Each step() splits a minibatch into one shard per replica and
+    every replica trains on it's shard concurrently, applying it's own
+    weight updates after each sample (local SGD). Afterwards the changes
+    of the parameters and training state of all replicas are weighted
+    by the shard sizes and summed in a fixed binary tree.
+    The network receives this average and is broadcast to all replicas.
+
+    This is NOT the all-reduce of gradients followed by one optimizer
+    step: within a shard the gradients are taken at the already updated
+    replica, and rules that are not linear in the gradient (RMSProp, Adam)
+    update their state per replica. Only for SGD with momentum and one
+    sample per shard the result equals the update of the averaged gradient.
+
+    The parameters of each replica live in a ParameterArena,
+    so the reduction runs over one continuous array per replica.
+    For a fixed layout, Layer::setLean() of the network is disabled
+    on construction. Copies of the network taken with Layer::getCopy()
+    between steps keep their values.
+
+    For a fixed thread count, shard function and sample order the
+    results are bit-identical between runs.
+    The shard function must therefore not use global state like
+    rand(), Random::local() or shared scratch buffers.
+*/
+template <typename Float>
+class ModelAveraging
+{
+    ModelAveraging(const ModelAveraging&) = delete;
+    void operator = (const ModelAveraging&) = delete;
+
+public:
+
+    /** Trains entries [begin, end) of the current minibatch on @p replica */
+    typedef std::function<void(Layer<Float>& replica, size_t replicaIndex,
+                               size_t begin, size_t end)> ShardFunc;
+
+    /** Creates @p numReplicas copies of @p net, one per core if 0.
+        The network is NOT owned and must stay valid. */
+    explicit ModelAveraging(Layer<Float>& net, size_t numReplicas = 0);
+
+    ~ModelAveraging();
+
+    // ------------ getter ---------------
+
+    size_t numReplicas() const { return replica_.size(); }
+
+    Layer<Float>& network() { return net_; }
+    const Layer<Float>& network() const { return net_; }
+
+    Layer<Float>& replica(size_t index) { return *replica_[index]; }
+    const Layer<Float>& replica(size_t index) const { return *replica_[index]; }
+
+    /** Returns the first index of the shard of @p replicaIndex
+        for a minibatch of @p batchSize entries */
+    size_t shardBegin(size_t replicaIndex, size_t batchSize) const;
+
+    // ------------ training -------------
+
+    /** Runs one synchronous training step over @p batchSize entries.
+        @p func is called concurrently for each non-empty shard.
+        Afterwards the network and all replicas hold the average
+        of the trained replicas. */
+    void step(size_t batchSize, const ShardFunc& func);
+
+    /** Copies all parameters and training state of the network into
+        the replicas. Must be called when the network was changed
+        from outside, e.g. after loading weights.
+        @throws MNN::Exception if the layout does not match anymore */
+    void broadcast();
+
+private:
+
+    void getBlocks_();
+    void copyToReplicas_();
+    /** Adds all blocks of replica @p src to replica @p dst */
+    void accumulate_(size_t dst, size_t src);
+
+    Layer<Float>& net_;
+    std::vector<Layer<Float>*> replica_;
+    std::vector<std::unique_ptr<ParameterArena<Float>>> arena_;
+    std::vector<ParameterBlock<Float>> netBlocks_;
+    std::vector<std::vector<ParameterBlock<Float>>> replicaBlocks_;
+    ThreadPool pool_;
+};
+
+#include "model_averaging_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_MODEL_AVERAGING_H
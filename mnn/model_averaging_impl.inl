@@ -0,0 +1,162 @@
+/** @file model_averaging_impl.inl
+
+    @brief ModelAveraging implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_MODELAVERAGING ModelAveraging<Float>
+
+MNN_TEMPLATE
+MNN_MODELAVERAGING::ModelAveraging(Layer<Float>& net, size_t numReplicas)
+    : net_      (net)
+    , pool_     (numReplicas)
+{
+    // all training state must exist before the arenas are created
+    net_.setLean(false);
+
+    for (size_t i = 0; i < pool_.numThreads(); ++i)
+    {
+        replica_.push_back(net_.getCopy());
+        arena_.emplace_back(new ParameterArena<Float>(*replica_.back()));
+    }
+
+    getBlocks_();
+}
+
+MNN_TEMPLATE
+MNN_MODELAVERAGING::~ModelAveraging()
+{
+    for (auto r : replica_)
+        delete r;
+}
+
+MNN_TEMPLATE
+void MNN_MODELAVERAGING::getBlocks_()
+{
+    netBlocks_.clear();
+    net_.getParameterBlocks(netBlocks_);
+
+    replicaBlocks_.resize(replica_.size());
+    for (size_t i = 0; i < replica_.size(); ++i)
+    {
+        auto& blocks = replicaBlocks_[i];
+        blocks.clear();
+        replica_[i]->getParameterBlocks(blocks);
+
+        bool match = blocks.size() == netBlocks_.size();
+        for (size_t j = 0; match && j < blocks.size(); ++j)
+            match = blocks[j].size == netBlocks_[j].size;
+        if (!match)
+            MNN_EXCEPTION("Parameter layout of replica " << i
+                          << " does not match network in ModelAveraging");
+    }
+}
+
+MNN_TEMPLATE
+void MNN_MODELAVERAGING::broadcast()
+{
+    getBlocks_();
+    copyToReplicas_();
+}
+
+MNN_TEMPLATE
+void MNN_MODELAVERAGING::copyToReplicas_()
+{
+    pool_.parallelFor(replica_.size(), [this](size_t r)
+    {
+        auto& blocks = replicaBlocks_[r];
+        for (size_t j = 0; j < blocks.size(); ++j)
+            std::copy(netBlocks_[j].data, netBlocks_[j].data + netBlocks_[j].size,
+                      blocks[j].data);
+    });
+}
+
+MNN_TEMPLATE
+size_t MNN_MODELAVERAGING::shardBegin(size_t r, size_t batchSize) const
+{
+    // the first (batchSize % numReplicas) shards get one more entry
+    const size_t num = replica_.size(),
+                 base = batchSize / num,
+                 rest = batchSize % num;
+    return r * base + std::min(r, rest);
+}
+
+MNN_TEMPLATE
+void MNN_MODELAVERAGING::accumulate_(size_t dst, size_t src)
+{
+    // same layout in all arenas, the gaps are zero
+    Float* d = arena_[dst]->data();
+    const Float* s = arena_[src]->data();
+    const size_t num = arena_[dst]->size();
+    for (size_t i = 0; i < num; ++i)
+        d[i] += s[i];
+}
+
+MNN_TEMPLATE
+void MNN_MODELAVERAGING::step(size_t batchSize, const ShardFunc& func)
+{
+    const size_t numActive = std::min(batchSize, replica_.size());
+    if (numActive == 0)
+        return;
+
+    // renew the pointers through the non-const accessors, which detach
+    // the parameters from copies, e.g. Layer::getCopy() snapshots
+    netBlocks_.clear();
+    net_.getParameterBlocks(netBlocks_);
+
+    // train each shard and turn the replica into it's weighted delta
+    pool_.parallelFor(numActive, [&](size_t r)
+    {
+        const size_t begin = shardBegin(r, batchSize),
+                     end = shardBegin(r + 1, batchSize);
+
+        func(*replica_[r], r, begin, end);
+
+        const Float weight = Float(end - begin) / batchSize;
+        auto& blocks = replicaBlocks_[r];
+        for (size_t j = 0; j < blocks.size(); ++j)
+        {
+            Float* d = blocks[j].data;
+            const Float* p = netBlocks_[j].data;
+            for (size_t i = 0; i < blocks[j].size; ++i)
+                d[i] = weight * (d[i] - p[i]);
+        }
+    });
+
+    // tree-reduce the deltas into replica 0
+    // (fixed pairing, so the summation order never changes)
+    for (size_t stride = 1; stride < numActive; stride *= 2)
+    {
+        const size_t numPairs = (numActive + 2 * stride - 1) / (2 * stride);
+        pool_.parallelFor(numPairs, [&](size_t k)
+        {
+            const size_t dst = k * 2 * stride,
+                         src = dst + stride;
+            if (src < numActive)
+                accumulate_(dst, src);
+        });
+    }
+
+    // apply to network
+    {
+        auto& blocks = replicaBlocks_[0];
+        for (size_t j = 0; j < blocks.size(); ++j)
+        {
+            Float* p = netBlocks_[j].data;
+            const Float* d = blocks[j].data;
+            for (size_t i = 0; i < blocks[j].size; ++i)
+                p[i] += d[i];
+        }
+    }
+
+    copyToReplicas_();
+}
+
+
+#undef MNN_TEMPLATE
+#undef MNN_MODELAVERAGING
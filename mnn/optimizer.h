@@ -0,0 +1,305 @@
+/** @file optimizer.h
+
+    @brief Weight update rules (SGD, Nesterov, RMSProp, Adam)
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_OPTIMIZER_H
+#define MNNSRC_OPTIMIZER_H
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+#include "layer.h"
+#include "exception.h"
+
+namespace MNN {
+
+/** Base of all weight update rules.
+
+    An optimizer holds the training state (e.g. momentum) of one
+    continuous parameter array of a layer. The layer calculates the
+    gradient (in the direction of the weight change, as everywhere in MNN)
+    and hands it to update() or updateScaled(), one block at a time.
+    @p offset is the index of the first parameter of the block within
+    the whole array and selects the matching training state.
+
+    Layers call nextStep() once before each training step.
+
+    In lean mode (setLean()), the state arrays are only allocated by
+    nextStep(), and only if the rule needs them with the current
+    settings, e.g. SGD with zero momentum keeps no state at all.
+    releaseState() frees the state of layers that are not trained.
+
+    All optimizers share the same set of settings, which are
+    interpreted by each rule as documented in the derived class.
+*/
+template <typename Float>
+class Optimizer
+{
+public:
+
+    Optimizer();
+    virtual ~Optimizer() { }
+
+    // ----------- copying -------------------
+
+    /** Returns a deep copy, including training state */
+    virtual Optimizer<Float>* getCopy() const = 0;
+
+    /** Creates an optimizer from it's id, or returns NULL */
+    static Optimizer<Float>* create(const std::string& id);
+
+    /** Copies settings and training state from @p other if it is
+        of the same type, returns false otherwise.
+        State arrays of unchanged size keep their memory,
+        e.g. inside a ParameterArena. */
+    bool assign(const Optimizer<Float>& other);
+
+    // ------------ settings -----------------
+
+    Float momentum() const { return momentum_; }
+    Float decay() const { return decay_; }
+    Float epsilon() const { return epsilon_; }
+
+    void setMomentum(Float m)
+    {
+        momentum_ = m;
+        if (lean_ && !needsState())
+            releaseState();
+    }
+    void setDecay(Float d) { decay_ = d; }
+    void setEpsilon(Float e) { epsilon_ = e; }
+
+    /** Enables lean mode, see class description.
+        Enabling frees the state if the rule does not need it,
+        disabling allocates it. */
+    void setLean(bool lean);
+
+    // ------------ getter -------------------
+
+    virtual const char* id() const = 0;
+    virtual const char* name() const = 0;
+
+    /** Number of state values per parameter */
+    virtual size_t numStates() const = 0;
+
+    /** Returns true if update() uses the state arrays
+        with the current settings */
+    virtual bool needsState() const { return true; }
+
+    bool isLean() const { return lean_; }
+
+    /** Returns true if the state arrays are allocated */
+    bool hasState() const { return !state_.empty(); }
+
+    /** Size of the allocated state arrays in bytes */
+    size_t stateBytes() const { return state_.size() * numParams_ * sizeof(Float); }
+
+    /** Number of parameters */
+    size_t numParameters() const { return numParams_; }
+
+    /** Number of calls to nextStep() since last reset() */
+    size_t numSteps() const { return step_; }
+
+    // ------------ state --------------------
+
+    /** Sets the number of parameters, resets training state on change.
+        In lean mode the state is freed instead. */
+    void resize(size_t numParameters);
+
+    /** Clears the training state */
+    void reset();
+
+    /** Frees the training state arrays, e.g. of a frozen layer.
+        The next nextStep() allocates them again, set to zero. */
+    void releaseState();
+
+    /** Appends the training state arrays as PT_STATE */
+    void getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks);
+
+    // ------------ update -------------------
+
+    /** Starts a new training step */
+    void nextStep()
+    {
+        if (state_.empty() && (!lean_ || needsState()))
+            allocateState_();
+        ++step_;
+    }
+
+    /** Adds the update for @p gradient to @p param.
+        All arrays are of length @p num. */
+    virtual void update(Float* param, size_t offset, const Float* gradient,
+                        size_t num, Float learnRate) = 0;
+
+    /** Same as update() for the gradient @p scale * @p vec.
+        Used for the outer products of dense layers, one row at a time. */
+    virtual void updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                              size_t num, Float learnRate) = 0;
+
+    // ------------ io -----------------------
+
+    /** Writes id, settings and training state */
+    void serialize(std::ostream&) const;
+
+    /** Reads an optimizer written by serialize().
+        @throws MNN::Exception on unknown id */
+    static Optimizer<Float>* createFromStream(std::istream&);
+
+    /** Writes id, settings and training state in the binary format */
+    void serializeBinary(BinaryWriter&) const;
+
+    /** Reads an optimizer written by serializeBinary().
+        @throws MNN::Exception on unknown id */
+    static Optimizer<Float>* createFromBinary(BinaryReader&);
+
+    /** Prints the settings */
+    void info(std::ostream& out = std::cout) const;
+
+protected:
+
+    void deserialize_(std::istream&);
+    void deserializeBinary_(BinaryReader&);
+
+    /** Allocates all state arrays, set to zero */
+    void allocateState_();
+
+    Float* stateData_(size_t index, size_t offset) { return &state_[index][offset]; }
+
+    Float momentum_, decay_, epsilon_;
+    size_t numParams_, step_;
+    bool lean_;
+    std::vector<Buffer<Float>> state_;
+};
+
+
+/** Stochastic gradient descent with classic momentum.
+
+    v = momentum * v + lr * g;
+    w += v */
+template <typename Float>
+class OptimizerSgd : public Optimizer<Float>
+{
+public:
+    virtual OptimizerSgd<Float>* getCopy() const override
+        { return new OptimizerSgd<Float>(*this); }
+
+    static const char* static_id() { return "sgd"; }
+    virtual const char* id() const override { return static_id(); }
+    virtual const char* name() const override { return "SGD"; }
+    virtual size_t numStates() const override { return 1; }
+    virtual bool needsState() const override { return this->momentum_ != Float(0); }
+
+    virtual void update(Float* param, size_t offset, const Float* gradient,
+                        size_t num, Float learnRate) override;
+    virtual void updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                              size_t num, Float learnRate) override;
+
+private:
+    template <class Grad>
+    void apply_(Float* param, size_t offset, size_t num, Float learnRate, Grad grad);
+};
+
+
+/** Stochastic gradient descent with Nesterov momentum.
+
+    v = momentum * v + lr * g;
+    w += momentum * v + lr * g */
+template <typename Float>
+class OptimizerNesterov : public Optimizer<Float>
+{
+public:
+    virtual OptimizerNesterov<Float>* getCopy() const override
+        { return new OptimizerNesterov<Float>(*this); }
+
+    static const char* static_id() { return "nesterov"; }
+    virtual const char* id() const override { return static_id(); }
+    virtual const char* name() const override { return "Nesterov"; }
+    virtual size_t numStates() const override { return 1; }
+    virtual bool needsState() const override { return this->momentum_ != Float(0); }
+
+    virtual void update(Float* param, size_t offset, const Float* gradient,
+                        size_t num, Float learnRate) override;
+    virtual void updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                              size_t num, Float learnRate) override;
+
+private:
+    template <class Grad>
+    void apply_(Float* param, size_t offset, size_t num, Float learnRate, Grad grad);
+};
+
+
+/** RMSProp with momentum.
+
+    s = decay * s + (1 - decay) * g^2;
+    v = momentum * v + lr * g / (sqrt(s) + epsilon);
+    w += v */
+template <typename Float>
+class OptimizerRmsProp : public Optimizer<Float>
+{
+public:
+    OptimizerRmsProp() { this->decay_ = Float(.9); }
+
+    virtual OptimizerRmsProp<Float>* getCopy() const override
+        { return new OptimizerRmsProp<Float>(*this); }
+
+    static const char* static_id() { return "rmsprop"; }
+    virtual const char* id() const override { return static_id(); }
+    virtual const char* name() const override { return "RMSProp"; }
+    virtual size_t numStates() const override { return 2; }
+
+    virtual void update(Float* param, size_t offset, const Float* gradient,
+                        size_t num, Float learnRate) override;
+    virtual void updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                              size_t num, Float learnRate) override;
+
+private:
+    template <class Grad>
+    void apply_(Float* param, size_t offset, size_t num, Float learnRate, Grad grad);
+};
+
+
+/** Adam, using momentum() as beta1 and decay() as beta2,
+    which default to 0.9 and 0.999.
+
+    m = beta1 * m + (1 - beta1) * g;
+    v = beta2 * v + (1 - beta2) * g^2;
+    w += lr * m' / (sqrt(v') + epsilon),
+    with m' and v' corrected for their zero initialization */
+template <typename Float>
+class OptimizerAdam : public Optimizer<Float>
+{
+public:
+    OptimizerAdam() { this->momentum_ = Float(.9); }
+
+    virtual OptimizerAdam<Float>* getCopy() const override
+        { return new OptimizerAdam<Float>(*this); }
+
+    static const char* static_id() { return "adam"; }
+    virtual const char* id() const override { return static_id(); }
+    virtual const char* name() const override { return "Adam"; }
+    virtual size_t numStates() const override { return 2; }
+
+    virtual void update(Float* param, size_t offset, const Float* gradient,
+                        size_t num, Float learnRate) override;
+    virtual void updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                              size_t num, Float learnRate) override;
+
+private:
+    template <class Grad>
+    void apply_(Float* param, size_t offset, size_t num, Float learnRate, Grad grad);
+};
+
+#include "optimizer_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_OPTIMIZER_H
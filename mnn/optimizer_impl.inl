@@ -0,0 +1,419 @@
+/** @file optimizer_impl.inl
+
+    @brief Optimizer implementations
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+
+MNN_TEMPLATE
+Optimizer<Float>::Optimizer()
+    : momentum_     (.1)
+    , decay_        (.999)
+    , epsilon_      (1e-8)
+    , numParams_    (0)
+    , step_         (0)
+    , lean_         (false)
+{
+}
+
+MNN_TEMPLATE
+Optimizer<Float>* Optimizer<Float>::create(const std::string& id)
+{
+    if (id == OptimizerSgd<Float>::static_id())
+        return new OptimizerSgd<Float>();
+    if (id == OptimizerNesterov<Float>::static_id())
+        return new OptimizerNesterov<Float>();
+    if (id == OptimizerRmsProp<Float>::static_id())
+        return new OptimizerRmsProp<Float>();
+    if (id == OptimizerAdam<Float>::static_id())
+        return new OptimizerAdam<Float>();
+    return 0;
+}
+
+MNN_TEMPLATE
+bool Optimizer<Float>::assign(const Optimizer<Float>& o)
+{
+    if (std::string(id()) != o.id())
+        return false;
+
+    momentum_ = o.momentum_;
+    decay_ = o.decay_;
+    epsilon_ = o.epsilon_;
+    numParams_ = o.numParams_;
+    step_ = o.step_;
+    lean_ = o.lean_;
+    state_.resize(o.state_.size());
+    for (size_t i = 0; i < state_.size(); ++i)
+        state_[i] = o.state_[i];
+    return true;
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::resize(size_t num)
+{
+    if (lean_)
+    {
+        if (num != numParams_)
+            releaseState();
+        numParams_ = num;
+        return;
+    }
+
+    if (num == numParams_ && state_.size() == numStates())
+        return;
+
+    numParams_ = num;
+    allocateState_();
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::allocateState_()
+{
+    state_.resize(numStates());
+    for (auto& s : state_)
+        s.resize(numParams_);
+    reset();
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::releaseState()
+{
+    std::vector<Buffer<Float>>().swap(state_);
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::setLean(bool lean)
+{
+    lean_ = lean;
+    if (lean_ && !needsState())
+        releaseState();
+    if (!lean_ && state_.empty())
+        allocateState_();
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::reset()
+{
+    for (auto& s : state_)
+        for (auto& f : s)
+            f = 0.;
+    step_ = 0;
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    for (auto& s : state_)
+        blocks.push_back({ s.data(), s.size(), PT_STATE, &s });
+}
+
+
+// ---------------- io -------------------
+
+MNN_TEMPLATE
+void Optimizer<Float>::serialize(std::ostream& s) const
+{
+    s << id();
+    // version
+    s << " " << 1;
+    // settings
+    s << " " << momentum_ << " " << decay_ << " " << epsilon_ << " " << step_;
+    // dimension
+    s << " " << numParams_ << " " << state_.size();
+    // state
+    for (auto& st : state_)
+    {
+        s << "\n";
+        for (auto v : st)
+            s << " " << v;
+    }
+}
+
+MNN_TEMPLATE
+Optimizer<Float>* Optimizer<Float>::createFromStream(std::istream& s)
+{
+    std::string str;
+    s >> str;
+    auto o = create(str);
+    if (!o)
+        MNN_EXCEPTION("Unknown optimizer '" << str << "' in stream");
+    try
+    {
+        o->deserialize_(s);
+    }
+    catch (...)
+    {
+        delete o;
+        throw;
+    }
+    return o;
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::deserialize_(std::istream& s)
+{
+    // version
+    int ver;
+    s >> ver;
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in optimizer " << name());
+    // settings
+    s >> momentum_ >> decay_ >> epsilon_ >> step_;
+    // dimension
+    size_t num, numSt;
+    s >> num >> numSt;
+    // lean optimizers may store no state
+    if (numSt != numStates() && numSt != 0)
+        MNN_EXCEPTION("Expected " << numStates() << " states in optimizer "
+                      << name() << ", found " << numSt);
+    const size_t step = step_;
+    resize(num);
+    if (numSt == 0)
+        releaseState();
+    else if (state_.empty())
+        allocateState_();
+    step_ = step;
+    // state
+    for (auto& st : state_)
+        Text::readValues(s, st.data(), st.size());
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::serializeBinary(BinaryWriter& w) const
+{
+    w.writeString(id());
+    // version
+    w.writeUInt(1);
+    // settings
+    w.writeFloat(momentum_);
+    w.writeFloat(decay_);
+    w.writeFloat(epsilon_);
+    w.writeUInt(step_);
+    // dimension
+    w.writeUInt(numParams_);
+    w.writeUInt(state_.size());
+    // state
+    for (auto& st : state_)
+        w.writeBlock(st.constData(), st.size());
+}
+
+MNN_TEMPLATE
+Optimizer<Float>* Optimizer<Float>::createFromBinary(BinaryReader& r)
+{
+    const std::string str = r.readString();
+    auto o = create(str);
+    if (!o)
+        MNN_EXCEPTION("Unknown optimizer '" << str << "' in binary model");
+    try
+    {
+        o->deserializeBinary_(r);
+    }
+    catch (...)
+    {
+        delete o;
+        throw;
+    }
+    return o;
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::deserializeBinary_(BinaryReader& r)
+{
+    // version
+    const uint64_t ver = r.readUInt();
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in optimizer " << name());
+    // settings
+    momentum_ = Float(r.readFloat());
+    decay_ = Float(r.readFloat());
+    epsilon_ = Float(r.readFloat());
+    step_ = size_t(r.readUInt());
+    // dimension
+    const size_t num = size_t(r.readUInt()),
+                 numSt = size_t(r.readUInt());
+    // lean optimizers may store no state
+    if (numSt != numStates() && numSt != 0)
+        MNN_EXCEPTION("Expected " << numStates() << " states in optimizer "
+                      << name() << ", found " << numSt);
+    // state, sized by the reader, maybe in a mapped file
+    numParams_ = num;
+    state_.resize(numSt);
+    for (auto& st : state_)
+        r.readBlock(st, num);
+}
+
+MNN_TEMPLATE
+void Optimizer<Float>::info(std::ostream& out) const
+{
+    out << name() << " (momentum " << momentum_;
+    if (numStates() > 1)
+        out << ", decay " << decay_;
+    out << ")";
+}
+
+
+// ---------------- sgd ------------------
+
+MNN_TEMPLATE
+template <class Grad>
+void OptimizerSgd<Float>::apply_(Float* param, size_t offset, size_t num, Float lr, Grad grad)
+{
+    // lean mode without momentum
+    if (!this->hasState())
+    {
+        for (size_t i = 0; i < num; ++i)
+            param[i] += lr * grad(i);
+        return;
+    }
+
+    Float* v = this->stateData_(0, offset);
+    const Float m = this->momentum_;
+    for (size_t i = 0; i < num; ++i)
+    {
+        v[i] = m * v[i] + lr * grad(i);
+        param[i] += v[i];
+    }
+}
+
+MNN_TEMPLATE
+void OptimizerSgd<Float>::update(Float* param, size_t offset, const Float* g,
+                                 size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [g](size_t i) { return g[i]; });
+}
+
+MNN_TEMPLATE
+void OptimizerSgd<Float>::updateScaled(Float* param, size_t offset, const Float* vec, Float scale,
+                                       size_t num, Float lr)
+{
+    // linear in the gradient, so the scale can go into the learnrate
+    apply_(param, offset, num, lr * scale, [vec](size_t i) { return vec[i]; });
+}
+
+
+// --------------- nesterov --------------
+
+MNN_TEMPLATE
+template <class Grad>
+void OptimizerNesterov<Float>::apply_(Float* param, size_t offset, size_t num, Float lr, Grad grad)
+{
+    // lean mode without momentum
+    if (!this->hasState())
+    {
+        for (size_t i = 0; i < num; ++i)
+            param[i] += lr * grad(i);
+        return;
+    }
+
+    Float* v = this->stateData_(0, offset);
+    const Float m = this->momentum_;
+    for (size_t i = 0; i < num; ++i)
+    {
+        const Float d = lr * grad(i);
+        v[i] = m * v[i] + d;
+        param[i] += m * v[i] + d;
+    }
+}
+
+MNN_TEMPLATE
+void OptimizerNesterov<Float>::update(Float* param, size_t offset, const Float* g,
+                                      size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [g](size_t i) { return g[i]; });
+}
+
+MNN_TEMPLATE
+void OptimizerNesterov<Float>::updateScaled(Float* param, size_t offset, const Float* vec,
+                                            Float scale, size_t num, Float lr)
+{
+    // linear in the gradient, so the scale can go into the learnrate
+    apply_(param, offset, num, lr * scale, [vec](size_t i) { return vec[i]; });
+}
+
+
+// --------------- rmsprop ---------------
+
+MNN_TEMPLATE
+template <class Grad>
+void OptimizerRmsProp<Float>::apply_(Float* param, size_t offset, size_t num, Float lr, Grad grad)
+{
+    Float* v = this->stateData_(0, offset);
+    Float* s = this->stateData_(1, offset);
+    const Float m = this->momentum_,
+                d = this->decay_,
+                d1 = Float(1) - d,
+                eps = this->epsilon_;
+    for (size_t i = 0; i < num; ++i)
+    {
+        const Float g = grad(i);
+        s[i] = d * s[i] + d1 * g * g;
+        v[i] = m * v[i] + lr * g / (std::sqrt(s[i]) + eps);
+        param[i] += v[i];
+    }
+}
+
+MNN_TEMPLATE
+void OptimizerRmsProp<Float>::update(Float* param, size_t offset, const Float* g,
+                                     size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [g](size_t i) { return g[i]; });
+}
+
+MNN_TEMPLATE
+void OptimizerRmsProp<Float>::updateScaled(Float* param, size_t offset, const Float* vec,
+                                           Float scale, size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [vec, scale](size_t i) { return scale * vec[i]; });
+}
+
+
+// ----------------- adam ----------------
+
+MNN_TEMPLATE
+template <class Grad>
+void OptimizerAdam<Float>::apply_(Float* param, size_t offset, size_t num, Float lr, Grad grad)
+{
+    Float* m = this->stateData_(0, offset);
+    Float* v = this->stateData_(1, offset);
+    const Float b1 = this->momentum_,
+                b2 = this->decay_,
+                b1r = Float(1) - b1,
+                b2r = Float(1) - b2;
+
+    // fold the bias correction of both moments into step size and epsilon
+    const Float t = std::max(size_t(1), this->step_),
+                c1 = Float(1) - std::pow(b1, t),
+                c2 = std::sqrt(Float(1) - std::pow(b2, t)),
+                step = c1 > Float(0) ? lr * c2 / c1 : lr,
+                eps = this->epsilon_ * c2;
+
+    for (size_t i = 0; i < num; ++i)
+    {
+        const Float g = grad(i);
+        m[i] = b1 * m[i] + b1r * g;
+        v[i] = b2 * v[i] + b2r * g * g;
+        param[i] += step * m[i] / (std::sqrt(v[i]) + eps);
+    }
+}
+
+MNN_TEMPLATE
+void OptimizerAdam<Float>::update(Float* param, size_t offset, const Float* g,
+                                  size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [g](size_t i) { return g[i]; });
+}
+
+MNN_TEMPLATE
+void OptimizerAdam<Float>::updateScaled(Float* param, size_t offset, const Float* vec,
+                                        Float scale, size_t num, Float lr)
+{
+    apply_(param, offset, num, lr, [vec, scale](size_t i) { return scale * vec[i]; });
+}
+
+
+#undef MNN_TEMPLATE
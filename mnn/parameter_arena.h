@@ -0,0 +1,107 @@
+/** @file parameter_arena.h
+
+    @brief One continuous block for all parameters of a network
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_PARAMETER_ARENA_H
+#define MNNSRC_PARAMETER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+#include "layer.h"
+#include "buffer.h"
+
+namespace MNN {
+
+/** Places all parameters and training state of a network in one
+    continuous, aligned memory block.
+
+    attach() moves every Buffer reported by Layer::getParameterBlocks()
+    into the arena, in the same order, with all PT_PARAMETER blocks first
+    and all PT_STATE blocks after them. Each block starts at an
+    alignment-byte boundary, the gaps are zero.
+    The layers keep working on their Buffer views as before, so
+    snapshots, averaging or optimizer sweeps over the whole network
+    become single loops over data() or parameters().
+
+    The memory is shared with the layers, so neither has to outlive
+    the other. If a layer is resized, gets a new optimizer or
+    allocates it's state in lean mode (Layer::setLean()), the
+    Buffer moves out of the arena and isValid() returns false,
+    until attach() is called again. Assigning a network of the same
+    layout with operator= keeps the values in the arena.
+*/
+template <typename Float>
+class ParameterArena
+{
+    ParameterArena(const ParameterArena&) = delete;
+    void operator = (const ParameterArena&) = delete;
+
+public:
+
+    /** Alignment of each block in bytes */
+    static const size_t alignment = 64;
+
+    ParameterArena() : data_(nullptr), size_(0), numParams_(0) { }
+
+    /** Calls attach() */
+    explicit ParameterArena(Layer<Float>& net) : ParameterArena() { attach(net); }
+
+    /** Moves all parameter and state Buffers of @p net into
+        a new memory block. The values are not changed.
+        @throws MNN::Exception if a block has no Buffer */
+    void attach(Layer<Float>& net);
+
+    /** Returns true if all parameters and state of @p net
+        live in this arena */
+    bool isValid(Layer<Float>& net) const;
+
+    // ------------ getter ---------------
+
+    /** The whole block */
+    Float* data() { return data_; }
+    const Float* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    /** All PT_PARAMETER blocks, the first numParameters() Floats of data() */
+    Float* parameters() { return data_; }
+    const Float* parameters() const { return data_; }
+    size_t numParameters() const { return numParams_; }
+
+    /** All PT_STATE blocks, following the parameters */
+    Float* state() { return data_ + numParams_; }
+    const Float* state() const { return data_ + numParams_; }
+    size_t numState() const { return size_ - numParams_; }
+
+    /** The blocks in the order of Layer::getParameterBlocks(),
+        pointing into data(). Only valid while the network exists. */
+    const std::vector<ParameterBlock<Float>>& blocks() const { return blocks_; }
+
+    /** Offset of the block @p index within data() */
+    size_t offset(size_t index) const { return offset_[index]; }
+
+private:
+
+    /** Rounds @p num Floats up to the alignment */
+    static size_t align_(size_t num);
+
+    std::shared_ptr<std::vector<Float>> memory_;
+    Float* data_;
+    size_t size_, numParams_;
+    std::vector<ParameterBlock<Float>> blocks_;
+    std::vector<size_t> offset_;
+};
+
+#include "parameter_arena_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_PARAMETER_ARENA_H
@@ -0,0 +1,81 @@
+/** @file parameter_arena_impl.inl
+
+    @brief ParameterArena implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_PARAMETERARENA ParameterArena<Float>
+
+MNN_TEMPLATE
+size_t MNN_PARAMETERARENA::align_(size_t num)
+{
+    const size_t a = std::max(size_t(1), alignment / sizeof(Float));
+    return (num + a - 1) / a * a;
+}
+
+MNN_TEMPLATE
+void MNN_PARAMETERARENA::attach(Layer<Float>& net)
+{
+    std::vector<ParameterBlock<Float>> blocks;
+    net.getParameterBlocks(blocks);
+    for (auto& b : blocks)
+        if (!b.buffer)
+            MNN_EXCEPTION("ParameterBlock without Buffer in ParameterArena");
+
+    // layout: parameters first, then state
+    std::vector<size_t> offset(blocks.size());
+    size_t pos = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const ParameterType type = pass == 0 ? PT_PARAMETER : PT_STATE;
+        for (size_t i = 0; i < blocks.size(); ++i)
+            if (blocks[i].type == type)
+            {
+                offset[i] = pos;
+                pos += align_(blocks[i].size);
+            }
+        if (pass == 0)
+            numParams_ = pos;
+    }
+
+    // over-allocate to align the start
+    const size_t pad = alignment / sizeof(Float) + 1;
+    memory_ = std::make_shared<std::vector<Float>>(pos + pad);
+    auto addr = reinterpret_cast<uintptr_t>(memory_->data());
+    addr = (addr + alignment - 1) / alignment * alignment;
+    data_ = reinterpret_cast<Float*>(addr);
+    size_ = pos;
+
+    // move the buffers
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        blocks[i].buffer->setView(data_ + offset[i], memory_);
+        blocks[i].data = blocks[i].buffer->data();
+    }
+
+    blocks_.swap(blocks);
+    offset_.swap(offset);
+}
+
+MNN_TEMPLATE
+bool MNN_PARAMETERARENA::isValid(Layer<Float>& net) const
+{
+    std::vector<ParameterBlock<Float>> blocks;
+    net.getParameterBlocks(blocks);
+    if (!data_ || blocks.size() != blocks_.size())
+        return false;
+    for (size_t i = 0; i < blocks.size(); ++i)
+        if (blocks[i].data != data_ + offset_[i]
+         || blocks[i].size != blocks_[i].size)
+            return false;
+    return true;
+}
+
+
+#undef MNN_TEMPLATE
+#undef MNN_PARAMETERARENA
@@ -0,0 +1,145 @@
+/** @file pipeline.h
+
+    @brief Pipeline-parallel training of serial stacks
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_PIPELINE_H
+#define MNNSRC_PIPELINE_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+
+#include "stack_serial.h"
+#include "thread_pool.h"
+
+namespace MNN {
+
+/** Pipelined training of a StackSerial.
+
+    The layers of the stack are partitioned into stages, one layer per stage
+    by default, and each stage runs on it's own thread.
+    Samples are streamed through the stages in micro-batches using a
+    one-forward-one-backward (1F1B) schedule: after a warm-up, each stage
+    alternates between the forward pass of a new micro-batch and the
+    backward pass of the oldest one in flight.
+
+    At most maxInFlight() micro-batches are between their forward and
+    backward pass, which bounds the staleness of the weights: the forward
+    pass of a stage may have seen up to maxInFlight() - 1 fewer weight updates
+    than it's backward pass. Each stage keeps a copy of it's input and
+    recomputes the forward pass before bprop(), so the layer states
+    always match the sample being trained.
+
+    With maxInFlight() == 1 the result is identical to calling
+    StackSerial::fprop() and bprop() for each sample.
+
+    StackSerial::shareActivations() of the stack is disabled
+    on construction and stays so.
+*/
+template <typename Float>
+class Pipeline
+{
+    Pipeline(const Pipeline&) = delete;
+    void operator = (const Pipeline&) = delete;
+
+public:
+
+    /** Returns the input of sample @p index.
+        Called from the first stage's thread in sample order.
+        The data only needs to be valid until the next call. */
+    typedef std::function<const Float*(size_t index)> InputFunc;
+
+    /** Writes the error for the @p output of sample @p index into @p error.
+        Called from the last stage's thread in sample order. */
+    typedef std::function<void(size_t index, const Float* output, Float* error)> ErrorFunc;
+
+    /** The stack is NOT owned and must stay valid.
+        Layers must not be added or removed while the pipeline exists. */
+    explicit Pipeline(StackSerial<Float>& net);
+
+    // ------------ settings -------------
+
+    /** Sets the index of the first layer of each stage.
+        Default is one stage per layer. */
+    void setStages(const std::vector<size_t>& firstLayers);
+
+    /** Sets the maximum number of micro-batches in flight.
+        0 (default) means the number of stages (full pipeline). */
+    void setMaxInFlight(size_t num) { maxInFlight_ = num; }
+
+    /** Sets the number of samples per micro-batch */
+    void setMicroBatchSize(size_t num) { microBatchSize_ = std::max(size_t(1), num); }
+
+    // ------------ getter ---------------
+
+    size_t numStages() const { return stage_.size(); }
+    size_t maxInFlight() const;
+    size_t microBatchSize() const { return microBatchSize_; }
+
+    // ------------ training -------------
+
+    /** Trains samples [0, @p numSamples) through the pipeline
+        with the given learnrate.
+        Blocks until all samples are processed.
+        Exceptions from any stage are rethrown here. */
+    void train(size_t numSamples, const InputFunc& input, const ErrorFunc& error,
+               Float learnRate = 1);
+
+private:
+
+    struct Stage
+    {
+        /** Range of layers [first, last) */
+        size_t first, last;
+        /** Activations and errors between layers of the stage */
+        std::vector<std::vector<Float>> act, err;
+        /** Output of the stage for recomputation and the error function */
+        std::vector<Float> out;
+        /** Index of micro-batch of last forward pass */
+        size_t lastForward;
+    };
+
+    /** A ring of micro-batch buffers */
+    struct Ring
+    {
+        std::vector<Float> data;
+        size_t width;
+        Float* sample(size_t microBatch, size_t m, size_t numSlots, size_t mbSize)
+            { return &data[((microBatch % numSlots) * mbSize + m) * width]; }
+    };
+
+    void resizeBuffers_();
+    void runStage_(size_t s);
+    bool forward_(size_t s, size_t mb);
+    bool backward_(size_t s, size_t mb);
+    void fpropStage_(Stage&, const Float* input, Float* output);
+    void bpropStage_(Stage&, const Float* error, Float* errorOutput);
+    size_t numInBatch_(size_t mb) const;
+
+    StackSerial<Float>& net_;
+    std::vector<Stage> stage_;
+    /** Input of each stage / error for the output of each stage */
+    std::vector<Ring> actRing_, errRing_;
+    /** Signals micro-batch index to next/previous stage */
+    std::vector<std::unique_ptr<Channel<size_t>>> actChannel_, errChannel_;
+    std::unique_ptr<ThreadPool> pool_;
+
+    size_t maxInFlight_, microBatchSize_,
+           numSlots_, numSamples_, numMicroBatches_;
+    Float learnRate_;
+    const InputFunc* inputFunc_;
+    const ErrorFunc* errorFunc_;
+};
+
+#include "pipeline_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_PIPELINE_H
@@ -0,0 +1,292 @@
+/** @file pipeline_impl.inl
+
+    @brief Pipeline implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_PIPELINE Pipeline<Float>
+
+MNN_TEMPLATE
+MNN_PIPELINE::Pipeline(StackSerial<Float>& net)
+    : net_              (net)
+    , maxInFlight_      (0)
+    , microBatchSize_   (1)
+    , numSlots_         (0)
+    , numSamples_       (0)
+    , numMicroBatches_  (0)
+    , learnRate_        (1)
+    , inputFunc_        (0)
+    , errorFunc_        (0)
+{
+    // neighbouring stages must not share their activations
+    net_.setShareActivations(false);
+
+    std::vector<size_t> first;
+    for (size_t i = 0; i < net_.numLayer(); ++i)
+        first.push_back(i);
+    setStages(first);
+}
+
+MNN_TEMPLATE
+void MNN_PIPELINE::setStages(const std::vector<size_t>& firstLayers)
+{
+    stage_.clear();
+    for (size_t i = 0; i < firstLayers.size(); ++i)
+    {
+        Stage s;
+        s.first = firstLayers[i];
+        s.last = i + 1 < firstLayers.size() ? firstLayers[i + 1] : net_.numLayer();
+        s.lastForward = size_t(-1);
+        if (s.first >= s.last || s.last > net_.numLayer())
+            MNN_EXCEPTION("Invalid stage " << i << " [" << s.first << ", " << s.last
+                          << ") for " << net_.numLayer() << " layers in Pipeline");
+        stage_.push_back(s);
+    }
+    if (!stage_.empty() && stage_.front().first != 0)
+        MNN_EXCEPTION("First stage must start with layer 0 in Pipeline");
+
+    pool_.reset();
+}
+
+MNN_TEMPLATE
+size_t MNN_PIPELINE::maxInFlight() const
+{
+    return maxInFlight_ ? maxInFlight_ : std::max(size_t(1), stage_.size());
+}
+
+MNN_TEMPLATE
+size_t MNN_PIPELINE::numInBatch_(size_t mb) const
+{
+    return std::min(microBatchSize_, numSamples_ - mb * microBatchSize_);
+}
+
+
+// -------------------- buffers ----------------------
+
+MNN_TEMPLATE
+void MNN_PIPELINE::resizeBuffers_()
+{
+    const size_t S = stage_.size();
+
+    // there are never more than maxInFlight() micro-batches
+    // between forward and backward pass, one more slot
+    // for the producer
+    numSlots_ = maxInFlight() + 1;
+
+    actRing_.resize(S);
+    errRing_.resize(S);
+    for (size_t s = 0; s < S; ++s)
+    {
+        Stage& st = stage_[s];
+        actRing_[s].width = net_.layer(st.first)->numIn();
+        actRing_[s].data.resize(numSlots_ * microBatchSize_ * actRing_[s].width);
+        errRing_[s].width = net_.layer(st.last - 1)->numOut();
+        errRing_[s].data.resize(numSlots_ * microBatchSize_ * errRing_[s].width);
+
+        st.act.resize(st.last - st.first - 1);
+        st.err.resize(st.act.size());
+        for (size_t i = 0; i < st.act.size(); ++i)
+        {
+            st.act[i].resize(net_.layer(st.first + i)->numOut());
+            st.err[i].resize(st.act[i].size());
+        }
+        st.out.resize(microBatchSize_ * errRing_[s].width);
+    }
+
+    while (actChannel_.size() < S)
+        actChannel_.push_back(std::unique_ptr<Channel<size_t>>(new Channel<size_t>));
+    while (errChannel_.size() < S)
+        errChannel_.push_back(std::unique_ptr<Channel<size_t>>(new Channel<size_t>));
+    for (size_t s = 0; s < S; ++s)
+    {
+        actChannel_[s]->reset();
+        errChannel_[s]->reset();
+    }
+
+    if (!pool_ || pool_->numThreads() != S)
+        pool_.reset(new ThreadPool(S));
+}
+
+
+// -------------------- training ---------------------
+
+MNN_TEMPLATE
+void MNN_PIPELINE::train(size_t numSamples, const InputFunc& input, const ErrorFunc& error,
+                         Float learnRate)
+{
+    if (stage_.empty() || numSamples == 0)
+        return;
+
+    numSamples_ = numSamples;
+    numMicroBatches_ = (numSamples + microBatchSize_ - 1) / microBatchSize_;
+    learnRate_ = learnRate;
+    inputFunc_ = &input;
+    errorFunc_ = &error;
+
+    resizeBuffers_();
+
+    pool_->parallelFor(stage_.size(), [this](size_t s)
+    {
+        try
+        {
+            runStage_(s);
+        }
+        catch (...)
+        {
+            // release the other stages
+            for (auto& c : actChannel_)
+                c->close();
+            for (auto& c : errChannel_)
+                c->close();
+            throw;
+        }
+    });
+
+    inputFunc_ = 0;
+    errorFunc_ = 0;
+}
+
+MNN_TEMPLATE
+void MNN_PIPELINE::runStage_(size_t s)
+{
+    const size_t S = stage_.size(),
+                 N = numMicroBatches_,
+                 // number of forward passes before the first backward pass
+                 warmup = std::min(N, std::min(S - s, maxInFlight()) - 1);
+
+    stage_[s].lastForward = size_t(-1);
+
+    // stops early when the channels are closed by another stage
+    size_t numF = 0, numB = 0;
+    while (numF < warmup)
+        if (!forward_(s, numF++))
+            return;
+
+    while (numB < N)
+    {
+        if (numF < N && !forward_(s, numF++))
+            return;
+        if (!backward_(s, numB++))
+            return;
+    }
+}
+
+MNN_TEMPLATE
+bool MNN_PIPELINE::forward_(size_t s, size_t mb)
+{
+    Stage& st = stage_[s];
+    const size_t num = numInBatch_(mb),
+                 S = stage_.size();
+    Ring& in = actRing_[s];
+
+    if (s == 0)
+    {
+        // copy the input, it's needed again for backward pass
+        for (size_t m = 0; m < num; ++m)
+        {
+            const Float* src = (*inputFunc_)(mb * microBatchSize_ + m);
+            std::copy(src, src + in.width,
+                      in.sample(mb, m, numSlots_, microBatchSize_));
+        }
+    }
+    else
+    {
+        size_t idx;
+        if (!actChannel_[s]->pop(idx))
+            return false;
+    }
+
+    if (s + 1 < S)
+    {
+        Ring& out = actRing_[s + 1];
+        for (size_t m = 0; m < num; ++m)
+            fpropStage_(st, in.sample(mb, m, numSlots_, microBatchSize_),
+                            out.sample(mb, m, numSlots_, microBatchSize_));
+        actChannel_[s + 1]->push(mb);
+    }
+    else
+    {
+        // last stage calculates the error
+        Ring& err = errRing_[s];
+        for (size_t m = 0; m < num; ++m)
+        {
+            Float* out = &st.out[m * err.width];
+            fpropStage_(st, in.sample(mb, m, numSlots_, microBatchSize_), out);
+            (*errorFunc_)(mb * microBatchSize_ + m, out,
+                          err.sample(mb, m, numSlots_, microBatchSize_));
+        }
+    }
+
+    st.lastForward = mb;
+    return true;
+}
+
+MNN_TEMPLATE
+bool MNN_PIPELINE::backward_(size_t s, size_t mb)
+{
+    Stage& st = stage_[s];
+    const size_t num = numInBatch_(mb),
+                 S = stage_.size();
+    Ring& in = actRing_[s];
+    Ring& err = errRing_[s];
+
+    if (s + 1 < S)
+    {
+        size_t idx;
+        if (!errChannel_[s]->pop(idx))
+            return false;
+    }
+
+    // the layer states are still valid if the last forward pass
+    // was the single sample of this micro-batch
+    const bool needRecompute = !(num == 1 && st.lastForward == mb);
+
+    for (size_t m = 0; m < num; ++m)
+    {
+        const Float* input = in.sample(mb, m, numSlots_, microBatchSize_);
+        if (needRecompute)
+            fpropStage_(st, input, &st.out[0]);
+
+        bpropStage_(st, err.sample(mb, m, numSlots_, microBatchSize_),
+                    s > 0 ? errRing_[s - 1].sample(mb, m, numSlots_, microBatchSize_) : 0);
+    }
+    st.lastForward = size_t(-1);
+
+    if (s > 0)
+        errChannel_[s - 1]->push(mb);
+    return true;
+}
+
+MNN_TEMPLATE
+void MNN_PIPELINE::fpropStage_(Stage& st, const Float* input, Float* output)
+{
+    const size_t num = st.last - st.first;
+    for (size_t i = 0; i < num; ++i)
+    {
+        net_.layer(st.first + i)->fprop(
+                    i == 0 ? input : &st.act[i - 1][0],
+                    i + 1 == num ? output : &st.act[i][0]);
+    }
+}
+
+MNN_TEMPLATE
+void MNN_PIPELINE::bpropStage_(Stage& st, const Float* error, Float* errorOutput)
+{
+    const size_t num = st.last - st.first;
+    for (size_t i = num; i > 0; --i)
+    {
+        net_.layer(st.first + i - 1)->bprop(
+                    i == num ? error : &st.err[i - 1][0],
+                    i == 1 ? errorOutput : &st.err[i - 2][0],
+                    learnRate_);
+    }
+}
+
+
+#undef MNN_TEMPLATE
+#undef MNN_PIPELINE
@@ -0,0 +1,263 @@
+/** @file random.h
+
+    @brief Fast per-thread random number generator
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_RANDOM_H
+#define MNNSRC_RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+namespace MNN {
+
+/** xoshiro256+ random number generator.
+
+    Runs Random::numLanes independent generators side by side,
+    with the state stored per word, so the fill functions
+    produce several numbers per step and the compiler can vectorize
+    the state update.
+
+    An engine is not thread-safe. Use Random::local(), which returns
+    an engine for the calling thread, seeded from Random::setSeed()
+    and the order in which the threads first used it.
+    rnd() and rndg() in function.h draw from Random::local().
+
+    @code
+    // binary states from probabilities
+    Random::local().bernoulli(states, num);
+    @endcode
+*/
+class Random
+{
+public:
+
+    /** Number of parallel generators */
+    static const size_t numLanes = 4;
+
+    explicit Random(uint64_t seed = 0x853c49e6748fea9bULL) { setState(seed); }
+
+    /** Reseeds the state of all lanes from @p seed */
+    void setState(uint64_t seed)
+    {
+        for (size_t w = 0; w < 4; ++w)
+            for (size_t l = 0; l < numLanes; ++l)
+                s_[w][l] = splitmix64_(seed);
+        cached_ = numLanes;
+    }
+
+    // ------------- per thread ------------
+
+    /** The engine of the calling thread */
+    static Random& local()
+    {
+        static thread_local Random r;
+        static thread_local uint64_t generation = ~uint64_t(0);
+        const uint64_t g = generation_().load(std::memory_order_relaxed);
+        if (generation != g)
+        {
+            generation = g;
+            r.setState(nextThreadSeed_());
+        }
+        return r;
+    }
+
+    /** Sets the base seed of all thread engines.
+        Every engine reseeds on it's next call to local().
+        The calling thread's engine gets the first stream,
+        other threads get the following streams in the order
+        in which they call local(). */
+    static void setSeed(uint64_t seed)
+    {
+        baseSeed_().store(seed, std::memory_order_relaxed);
+        threadCount_().store(0, std::memory_order_relaxed);
+        generation_().fetch_add(1, std::memory_order_relaxed);
+        local();
+    }
+
+    // ------------- single values ---------
+
+    /** Next 64 random bits */
+    uint64_t next()
+    {
+        if (cached_ >= numLanes)
+        {
+            step_(cache_);
+            cached_ = 0;
+        }
+        return cache_[cached_++];
+    }
+
+    /** Uniform value in [0,1) */
+    template <typename Float>
+    Float uniform() { return toUnit_<Float>(next()); }
+
+    /** Uniform value in [@p min, @p max) */
+    template <typename Float>
+    Float uniform(Float min, Float max)
+        { return min + toUnit_<Float>(next()) * (max - min); }
+
+    /** Normal distributed value */
+    template <typename Float>
+    Float gaussian(Float mean, Float dev)
+    {
+        Float v[2];
+        gaussianPair_(next(), next(), v);
+        return mean + dev * v[0];
+    }
+
+    /** Uniform index in [0, @p num) */
+    size_t index(size_t num)
+    {
+        const uint64_t r = next();
+        if (uint64_t(num) <= 0xffffffffULL)
+            return size_t(((r >> 32) * uint64_t(num)) >> 32);
+        return size_t(r % uint64_t(num));
+    }
+
+    // ------------- arrays ----------------
+
+    /** Fills @p num values with uniform values in [@p min, @p max) */
+    template <typename Float>
+    void fillUniform(Float* dst, size_t num, Float min, Float max)
+    {
+        const Float range = max - min;
+        uint64_t r[numLanes];
+        for (size_t i = 0; i < num; i += numLanes)
+        {
+            step_(r);
+            const size_t n = std::min(size_t(numLanes), num - i);
+            for (size_t l = 0; l < n; ++l)
+                dst[i + l] = min + toUnit_<Float>(r[l]) * range;
+        }
+    }
+
+    /** Adds uniform values in [@p min, @p max) to @p num values */
+    template <typename Float>
+    void addUniform(Float* dst, size_t num, Float min, Float max)
+    {
+        const Float range = max - min;
+        uint64_t r[numLanes];
+        for (size_t i = 0; i < num; i += numLanes)
+        {
+            step_(r);
+            const size_t n = std::min(size_t(numLanes), num - i);
+            for (size_t l = 0; l < n; ++l)
+                dst[i + l] += min + toUnit_<Float>(r[l]) * range;
+        }
+    }
+
+    /** Fills @p num values with normal distributed values */
+    template <typename Float>
+    void fillGaussian(Float* dst, size_t num, Float mean, Float dev)
+    {
+        uint64_t r[numLanes];
+        Float v[2];
+        for (size_t i = 0; i < num; i += numLanes)
+        {
+            step_(r);
+            const size_t n = std::min(size_t(numLanes), num - i);
+            for (size_t l = 0; l < n; l += 2)
+            {
+                gaussianPair_(r[l], r[l + 1], v);
+                dst[i + l] = mean + dev * v[0];
+                if (l + 1 < n)
+                    dst[i + l + 1] = mean + dev * v[1];
+            }
+        }
+    }
+
+    /** Replaces @p num probabilities in @p states
+        with binary samples, 1 with probability of the state */
+    template <typename Float>
+    void bernoulli(Float* states, size_t num)
+    {
+        uint64_t r[numLanes];
+        for (size_t i = 0; i < num; i += numLanes)
+        {
+            step_(r);
+            const size_t n = std::min(size_t(numLanes), num - i);
+            for (size_t l = 0; l < n; ++l)
+                states[i + l] = states[i + l] > toUnit_<Float>(r[l])
+                        ? Float(1) : Float(0);
+        }
+    }
+
+private:
+
+    /** One xoshiro256+ step of all lanes */
+    void step_(uint64_t* result)
+    {
+        for (size_t l = 0; l < numLanes; ++l)
+        {
+            result[l] = s_[0][l] + s_[3][l];
+            const uint64_t t = s_[1][l] << 17;
+            s_[2][l] ^= s_[0][l];
+            s_[3][l] ^= s_[1][l];
+            s_[1][l] ^= s_[2][l];
+            s_[0][l] ^= s_[3][l];
+            s_[2][l] ^= t;
+            s_[3][l] = (s_[3][l] << 45) | (s_[3][l] >> 19);
+        }
+    }
+
+    /** Upper bits to [0,1), in the precision of Float
+        so that float never rounds up to 1 */
+    template <typename Float>
+    static Float toUnit_(uint64_t r)
+    {
+        if (sizeof(Float) <= sizeof(float))
+            return Float(r >> 40) * Float(1. / 16777216.);
+        return Float(r >> 11) * Float(1. / 9007199254740992.);
+    }
+
+    /** Box-Muller transform of two random words */
+    template <typename Float>
+    static void gaussianPair_(uint64_t r1, uint64_t r2, Float* v)
+    {
+        const double u1 = double((r1 >> 11) + 1) * (1. / 9007199254740992.),
+                     u2 = double(r2 >> 11) * (1. / 9007199254740992.),
+                     m = std::sqrt(-2. * std::log(u1)),
+                     a = 6.283185307179586 * u2;
+        v[0] = Float(m * std::cos(a));
+        v[1] = Float(m * std::sin(a));
+    }
+
+    static uint64_t splitmix64_(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t nextThreadSeed_()
+    {
+        const uint64_t i = threadCount_().fetch_add(1, std::memory_order_relaxed);
+        return baseSeed_().load(std::memory_order_relaxed)
+                + i * 0x2545f4914f6cdd1dULL;
+    }
+
+    static std::atomic<uint64_t>& baseSeed_()
+        { static std::atomic<uint64_t> s(0x853c49e6748fea9bULL); return s; }
+    static std::atomic<uint64_t>& threadCount_()
+        { static std::atomic<uint64_t> s(0); return s; }
+    static std::atomic<uint64_t>& generation_()
+        { static std::atomic<uint64_t> s(0); return s; }
+
+    uint64_t s_[4][numLanes],
+             cache_[numLanes];
+    size_t cached_;
+};
+
+} // namespace MNN
+
+#endif // MNNSRC_RANDOM_H
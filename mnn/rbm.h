@@ -13,11 +13,13 @@
 
 #include <cmath>
 #include <vector>
+#include <memory>
 #include <iostream>
 
 #include "layer.h"
 #include "interface.h"
 #include "activation.h"
+#include "optimizer.h"
 
 namespace MNN {
 
@@ -30,6 +32,8 @@ class Rbm
         : public Layer<Float>
         , public GetMomentumInterface<Float>
         , public SetMomentumInterface<Float>
+        , public GetOptimizerInterface<Float>
+        , public SetOptimizerInterface<Float>
         , public SetLearnRateInterface<Float>
         , public GetLearnRateInterface<Float>
         , public ContrastiveDivergenceInterface<Float>
@@ -45,12 +49,25 @@ class Rbm
     virtual Rbm<Float, ActFunc> * cloneClass() const override
         { return new Rbm<Float, ActFunc>(numIn(), numOut(), learnRate_, biasCell_); }
 
+    /** Starts from an empty layer, so the copy only shares the buffers */
+    virtual Rbm<Float, ActFunc> * getCopy() const override
+        {
+            auto l = new Rbm<Float, ActFunc>(0, 0, learnRate_, false);
+            *l = static_cast<const Layer<Float>&>(*this);
+            return l;
+        }
+
     virtual Rbm<Float, ActFunc>& operator = (const Layer<Float>&) override;
 
     // --------- MomentumInterface -----------
 
-    virtual Float momentum() const override { return momentum_; }
-    virtual void setMomentum(Float m) override { momentum_ = m; }
+    virtual Float momentum() const override { return optimizer_->momentum(); }
+    virtual void setMomentum(Float m) override { optimizer_->setMomentum(m); }
+
+    // --------- OptimizerInterface ----------
+
+    virtual const Optimizer<Float>& optimizer() const override { return *optimizer_; }
+    virtual void setOptimizer(const Optimizer<Float>& opt) override;
 
     // --------- LearnRateInterface ----------
 
@@ -69,6 +86,9 @@ class Rbm
     virtual const Float* outputs() const override { return &output_[0]; }
     virtual const Float* weights() const override { return &weight_[0]; }
     virtual Float* weights() override { return &weight_[0]; }
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>&) override;
+    virtual void setLean(bool lean) override { optimizer_->setLean(lean); }
+    virtual void releaseTrainingState() override;
 
     virtual Float weight(size_t input, size_t output) const override
         { return weights()[output * input_.size() + input]; }
@@ -78,6 +98,14 @@ class Rbm
     // ------- propagation -------------------
 
     virtual void fprop(const Float * input, Float * output) override;
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const override;
+    virtual size_t workspaceSize() const override
+        { return biasCell_ ? input_.size() : 0; }
+    virtual void inferBatch(const Float * input, Float * output, size_t num,
+                            Workspace<Float>& workspace) const override;
+    virtual size_t workspaceSizeBatch(size_t num) const override
+        { return biasCell_ ? num * input_.size() : 0; }
 
     virtual void bprop(const Float * error, Float * error_output = 0,
                        Float global_learn_rate = 1) override;
@@ -87,6 +115,32 @@ class Rbm
     virtual Float contrastiveDivergence(
             const Float* input, size_t numSteps = 1, Float learn_rate = 1) override;
 
+    /** Contrastive divergence training of @p batchSize samples at once.
+        @p input holds batchSize * numIn() values, one sample after
+        the other. All Gibbs chains run together, so each weight row is
+        read once per batch instead of once per sample, and the weights
+        are updated once with the statistics averaged over the batch.
+        With @p batchSize 1 this is identical to contrastiveDivergence().
+        Returns the average of the per-sample errors */
+    Float contrastiveDivergenceBatch(const Float* input, size_t batchSize,
+                                     size_t numSteps = 1, Float learn_rate = 1);
+
+    /** Enables persistent contrastive divergence (PCD).
+        The negative phase then does not start at the data but continues
+        a pool of fantasy chains, one per batch sample, which persist
+        between updates and are stored by serialize().
+        A few Gibbs steps per update (even 1) are enough, as the chains
+        approach the model distribution over the course of training. */
+    void setPersistent(bool enable);
+    bool isPersistent() const { return persistent_; }
+
+    /** Restarts the fantasy chains from the next training data */
+    void resetPersistentChains() { std::vector<Float>().swap(fantasy_); }
+
+    /** Number of fantasy chains of the PCD mode, 0 until the first update */
+    size_t numPersistentChains() const
+        { return input_.empty() ? 0 : fantasy_.size() / input_.size(); }
+
     /** Returns the sum of the absolute difference between
         @p input and the current input state */
     Float compareInput(const Float* input) const;
@@ -97,6 +151,7 @@ class Rbm
     virtual const char * id() const override { return static_id(); }
     virtual const char * name() const override { return "RBM"; }
     virtual size_t numParameters() const override { return weight_.size(); }
+    virtual void getMemoryUsage(MemoryUsage&) const override;
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const override;
     virtual void dump(std::ostream &out = std::cout) const override;
@@ -107,40 +162,80 @@ class Rbm
 
     virtual void serialize(std::ostream&) const override;
     virtual void deserialize(std::istream&) override;
+    virtual void serializeBinary(BinaryWriter&) const override;
+    virtual void deserializeBinary(BinaryReader&) override;
 
 protected:
 
     void copyInput_(const Float* input);
 
-    /** Propagates input_ to output_ through weightUp_ */
-    void propUp_();
+    /** Propagates input_ to output_ */
+    void propUp_() { propUp_(&input_[0], &output_[0], 1); }
 
-    /** Propagates output_ to input_ through weightDown_ */
-    void propDown_();
+    /** Propagates @p num visible vectors @p v to the hidden vectors @p h,
+        with DenseMatrix::fprop_batch() */
+    void propUp_(const Float* v, Float* h, size_t num) const;
+
+    /** Propagates @p num hidden vectors @p h to the visible vectors @p v,
+        with DenseMatrix::fprop_transpose_batch() */
+    void propDown_(const Float* h, Float* v, size_t num) const;
 
     /** Makes states binary */
     static void makeBinary_(Float* states, size_t num);
-    void makeBinaryInput_() { makeBinary_(&input_[0], input_.size()); }
-    void makeBinaryOutput_() { makeBinary_(&output_[0], output_.size()); }
-
-    void getCorrelation_(Float* matrix) const;
 
-    /** Adjust weights by reconstruction/correlation error.
-        Returns sum of errors */
-    Float trainCorrelation_(Float learn_rate);
+    /** Runs @p numSteps of Gibbs sampling for the @p num chains
+        in @p v and @p h, which hold the input on call.
+        The data states are stored in @p v0 and @p h0,
+        the model states are left in @p v and @p h.
+        Then calls trainCorrelation_() */
+    Float contrastiveDivergence_(Float* v, Float* h, Float* v0, Float* h0,
+                                 size_t num, size_t numSteps, Float learn_rate);
+
+    /** Same as contrastiveDivergence_() but the model states in
+        @p v and @p h are sampled from the persistent chains */
+    Float persistentDivergence_(Float* v, Float* h, Float* v0, Float* h0,
+                                size_t num, size_t numSteps, Float learn_rate);
+
+    /** Sets the bias cell of @p num visible vectors to 1 */
+    void setBiasCells_(Float* v, size_t num) const;
+
+    /** Adjusts the weights by the difference of the data and the
+        model correlation, averaged over @p num samples,
+        one row at a time, without building the correlation matrices.
+        Returns average of absolute errors */
+    Float trainCorrelation_(const Float* v0, const Float* h0,
+                            const Float* v, const Float* h,
+                            size_t num, Float learn_rate);
+
+    /** Sizes the buffers to the input and output */
+    void resizeScratch_();
 
     std::vector<Float>
         input_,
         output_,
-        weight_,
-        prevDelta_,
-        correlationData_,
-        correlationModel_;
-
-    Float learnRate_,
-          momentum_;
-
-    bool biasCell_;
+        // data states of contrastive divergence
+        dataInput_,
+        dataOutput_,
+        // one row of the correlation difference
+        gradient_,
+        // states of contrastiveDivergenceBatch()
+        batchInput_,
+        batchOutput_,
+        batchDataInput_,
+        batchDataOutput_,
+        // visible states of the persistent chains
+        fantasy_;
+
+    /** Trainable parameters */
+    Buffer<Float>
+        weight_;
+
+    std::unique_ptr<Optimizer<Float>> optimizer_;
+
+    Float learnRate_;
+
+    bool biasCell_,
+        persistent_;
 };
 
 #include "rbm_impl.inl"
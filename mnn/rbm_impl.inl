@@ -13,9 +13,10 @@
 
 MNN_TEMPLATE
 MNN_RBM::Rbm(size_t nrIn, size_t nrOut, Float learnRate, bool bc)
-    : learnRate_	(learnRate)
-    , momentum_     (.1)
+    : optimizer_    (new OptimizerSgd<Float>())
+    , learnRate_	(learnRate)
     , biasCell_     (bc)
+    , persistent_   (false)
 {
     resize(nrIn, nrOut);
 }
@@ -36,12 +37,13 @@ Rbm<Float, ActFunc>& MNN_RBM::operator = (const Layer<Float>& layer)
     input_ = net->input_;
     output_ = net->output_;
     weight_ = net->weight_;
-    prevDelta_ = net->prevDelta_;
-    correlationData_ = net->correlationData_;
-    correlationModel_ = net->correlationModel_;
+    if (!optimizer_->assign(*net->optimizer_))
+        optimizer_.reset(net->optimizer_->getCopy());
+    resizeScratch_();
     learnRate_ = net->learnRate_;
-    momentum_ = net->momentum_;
     biasCell_ = net->biasCell_;
+    persistent_ = net->persistent_;
+    fantasy_ = net->fantasy_;
 
     return *this;
 }
@@ -56,14 +58,22 @@ void MNN_RBM::serialize(std::ostream& s) const
     // activation
     s << " " << ActFunc::static_name();
     // version
-    s << " " << 1;
+    s << " " << 3;
     // settings
-    s << " " << learnRate_ << " " << momentum_ << " " << biasCell_;
+    s << " " << learnRate_ << " " << momentum() << " " << biasCell_;
     // dimension
     s << " " << numIn() << " " << numOut() << "\n";
     // weights
     for (auto w : weight_)
         s << " " << w;
+    // optimizer (v2)
+    s << "\n";
+    optimizer_->serialize(s);
+    // persistent chains (v3)
+    s << "\n" << persistent_ << " " << numPersistentChains() << "\n";
+    for (auto f : fantasy_)
+        s << " " << f;
+    s << "\n";
 }
 
 MNN_TEMPLATE
@@ -79,18 +89,89 @@ void MNN_RBM::deserialize(std::istream& s)
     // version
     int ver;
     s >> ver;
-    if (ver > 1)
+    if (ver > 3)
         MNN_EXCEPTION("Wrong version in " << name());
 
     // settings
-    s >> learnRate_ >> momentum_ >> biasCell_;
+    Float mom;
+    s >> learnRate_ >> mom >> biasCell_;
     // dimension
     size_t numIn, numOut;
     s >> numIn >> numOut;
     resize(numIn, numOut);
     // weights
-    for (auto& w : weight_)
-        s >> w;
+    Text::readValues(s, weight_.data(), weight_.size());
+    // optimizer
+    if (ver >= 2)
+    {
+        optimizer_.reset(Optimizer<Float>::createFromStream(s));
+        if (optimizer_->numParameters() != weight_.size())
+            MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                          << " does not match " << weight_.size() << " weights in " << name());
+    }
+    else
+    {
+        optimizer_->setMomentum(mom);
+        optimizer_->reset();
+    }
+    // persistent chains
+    if (ver >= 3)
+    {
+        size_t numChains;
+        s >> persistent_ >> numChains;
+        fantasy_.resize(numChains * input_.size());
+        Text::readValues(s, fantasy_.data(), fantasy_.size());
+    }
+}
+
+MNN_TEMPLATE
+void MNN_RBM::serializeBinary(BinaryWriter& w) const
+{
+    w.beginLayer(id(), ActFunc::static_name(), 1);
+    // settings
+    w.writeFloat(learnRate_);
+    w.writeBool(biasCell_);
+    // dimension
+    w.writeUInt(numIn());
+    w.writeUInt(numOut());
+    // parameters
+    w.writeBlock(weight_.constData(), weight_.size());
+    optimizer_->serializeBinary(w);
+    // persistent chains
+    w.writeBool(persistent_);
+    w.writeUInt(numPersistentChains());
+    w.writeBlock(fantasy_.data(), fantasy_.size());
+    w.endLayer();
+}
+
+MNN_TEMPLATE
+void MNN_RBM::deserializeBinary(BinaryReader& r)
+{
+    const uint32_t ver = r.beginLayer(id());
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in " << name());
+
+    // settings
+    learnRate_ = Float(r.readFloat());
+    biasCell_ = r.readBool();
+    // dimension
+    const size_t numIn = size_t(r.readUInt()),
+                 numOut = size_t(r.readUInt());
+    // parameters, sized by the reader
+    r.readBlock(weight_, (numIn + biasCell_) * numOut);
+    // optimizer
+    optimizer_.reset(Optimizer<Float>::createFromBinary(r));
+    if (optimizer_->numParameters() != weight_.size())
+        MNN_EXCEPTION("Optimizer size " << optimizer_->numParameters()
+                      << " does not match " << weight_.size() << " weights in " << name());
+    // only sizes the rest, resets the chains
+    resize(numIn, numOut);
+    // persistent chains
+    persistent_ = r.readBool();
+    const size_t numChains = size_t(r.readUInt());
+    fantasy_.resize(numChains * input_.size());
+    r.readBlock(fantasy_.data(), fantasy_.size());
+    r.endLayer();
 }
 
 // ----------- nn interface --------------
@@ -103,9 +184,54 @@ void MNN_RBM::resize(size_t nrIn, size_t nrOut)
     input_.resize(nrIn);
     output_.resize(nrOut);
     weight_.resize(nrIn * nrOut);
-    prevDelta_.resize(nrIn * nrOut);
-    correlationData_.resize(nrIn * nrOut);
-    correlationModel_.resize(nrIn * nrOut);
+    optimizer_->resize(nrIn * nrOut);
+    resizeScratch_();
+    resetPersistentChains();
+}
+
+MNN_TEMPLATE
+void MNN_RBM::resizeScratch_()
+{
+    dataInput_.resize(input_.size());
+    dataOutput_.resize(output_.size());
+    gradient_.resize(input_.size());
+}
+
+MNN_TEMPLATE
+void MNN_RBM::setPersistent(bool enable)
+{
+    persistent_ = enable;
+    if (!persistent_)
+        resetPersistentChains();
+}
+
+MNN_TEMPLATE
+void MNN_RBM::releaseTrainingState()
+{
+    optimizer_->releaseState();
+    resetPersistentChains();
+    std::vector<Float>().swap(batchInput_);
+    std::vector<Float>().swap(batchOutput_);
+    std::vector<Float>().swap(batchDataInput_);
+    std::vector<Float>().swap(batchDataOutput_);
+}
+
+MNN_TEMPLATE
+void MNN_RBM::setOptimizer(const Optimizer<Float>& opt)
+{
+    const bool lean = optimizer_->isLean();
+    optimizer_.reset(opt.getCopy());
+    if (lean)
+        optimizer_->setLean(true);
+    optimizer_->resize(weight_.size());
+    optimizer_->reset();
+}
+
+MNN_TEMPLATE
+void MNN_RBM::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    blocks.push_back({ weight_.data(), weight_.size(), PT_PARAMETER, &weight_ });
+    optimizer_->getParameterBlocks(blocks);
 }
 
 
@@ -128,7 +254,7 @@ void MNN_RBM::grow(size_t nrIn, size_t nrOut, Float randomDev)
         for (i=0; i<input_.size(); ++i)
             weight[o * nrIn + i] = weight_[o * input_.size() + i];
         // choose random input to copy
-        size_t ri = size_t(rand()) % input_.size();
+        size_t ri = Random::local().index(input_.size());
         // run through additional inputs
         for (; i<nrIn; ++i)
             weight[o * nrIn + i] = weight_[o * input_.size() + ri]
@@ -138,8 +264,8 @@ void MNN_RBM::grow(size_t nrIn, size_t nrOut, Float randomDev)
     for (; o<nrOut; ++o)
     {
         // choose random input and output to copy
-        size_t ro = size_t(rand()) % output_.size();
-        size_t ri = size_t(rand()) % input_.size();
+        size_t ro = Random::local().index(output_.size());
+        size_t ri = Random::local().index(input_.size());
 
         size_t i;
         for (i=0; i<input_.size(); ++i)
@@ -154,9 +280,10 @@ void MNN_RBM::grow(size_t nrIn, size_t nrOut, Float randomDev)
     input_.resize(nrIn); for (auto&f : input_) f = 0;
     if (biasCell_) input_[input_.size()-1] = 1;
     output_.resize(nrOut); for (auto&f : output_) f = 0;
-    prevDelta_.resize(nrIn * nrOut); for (auto&f : prevDelta_) f = 0;
-    correlationData_.resize(nrIn * nrOut); for (auto&f : correlationData_) f = 0;
-    correlationModel_.resize(nrIn * nrOut); for (auto&f : correlationData_) f = 0;
+    optimizer_->resize(nrIn * nrOut);
+    optimizer_->reset();
+    resizeScratch_();
+    resetPersistentChains();
 }
 
 MNN_TEMPLATE
@@ -189,12 +316,10 @@ void MNN_RBM::brainwash(Float amp)
 
     // randomize weights (assume normalized states)
     Float f = amp / std::sqrt(input_.size());
-    for (auto& w : weight_)
-        w = rnd(-f, f);
+    Random::local().fillUniform(weight_.data(), weight_.size(), -f, f);
 
     // reset momentum
-    for (auto& f : prevDelta_)
-        f = 0.;
+    optimizer_->reset();
 }
 
 
@@ -211,6 +336,54 @@ void MNN_RBM::fprop(const Float * input, Float * output)
     std::copy(output_.begin(), output_.end(), output);
 }
 
+MNN_TEMPLATE
+void MNN_RBM::infer(const Float * input, Float * output,
+                    Workspace<Float>& workspace) const
+{
+    if (!biasCell_)
+    {
+        DenseMatrix::fprop<Float, ActFunc>(
+                    input, output, weight_.constData(), input_.size(), output_.size());
+        return;
+    }
+
+    // input with bias cell
+    const size_t mark = workspace.mark();
+    Float* v = workspace.allocate(input_.size());
+    std::copy(input, input + numIn(), v);
+    v[numIn()] = 1;
+
+    DenseMatrix::fprop<Float, ActFunc>(
+                v, output, weight_.constData(), input_.size(), output_.size());
+
+    workspace.release(mark);
+}
+
+MNN_TEMPLATE
+void MNN_RBM::inferBatch(const Float * input, Float * output, size_t num,
+                         Workspace<Float>& workspace) const
+{
+    if (!biasCell_)
+    {
+        propUp_(input, output, num);
+        return;
+    }
+
+    // inputs with bias cell
+    const size_t mark = workspace.mark();
+    Float* v = workspace.allocate(num * input_.size());
+    for (size_t b = 0; b < num; ++b, input += numIn())
+    {
+        Float* vb = v + b * input_.size();
+        std::copy(input, input + numIn(), vb);
+        vb[numIn()] = 1;
+    }
+
+    propUp_(v, output, num);
+
+    workspace.release(mark);
+}
+
 
 MNN_TEMPLATE
 void MNN_RBM::bprop(const Float * error, Float * error_output,
@@ -218,34 +391,21 @@ void MNN_RBM::bprop(const Float * error, Float * error_output,
 {
     global_learn_rate *= learnRate_;
 
-    const Float * e;
-
-    // pass error through
+    // pass error through, without the bias cell
     if (error_output)
-    for (size_t i = 0; i<numIn(); ++i, ++error_output)
-    {
-        Float sum = 0;
-        e = error;
-        for (size_t o = 0; o < output_.size(); ++o, ++e)
-        {
-            sum += *e * weight_[o * input_.size() + i];
-        }
-        *error_output = sum;
-    }
+        DenseMatrix::bprop_stride<Float>(
+                    error_output, error, weight_.constData(),
+                    numIn(), output_.size(), input_.size());
 
     // backprob derivative
-    Float* w = &weight_[0];
-    Float* pd = &prevDelta_[0];
-    for (auto o = output_.begin(); o != output_.end(); ++o, ++error)
+    const size_t numIn = input_.size();
+    optimizer_->nextStep();
+    for (size_t o = 0; o < output_.size(); ++o, ++error)
     {
-        Float de = ActFunc::derivative(*error, *o);
+        Float de = ActFunc::derivative(*error, output_[o]);
 
-        for (auto i = input_.begin(); i != input_.end(); ++i, ++w, ++pd)
-        {
-            *pd = momentum_ * *pd
-                + global_learn_rate * de * *i;
-            *w += *pd;
-        }
+        optimizer_->updateScaled(&weight_[o * numIn], o * numIn,
+                                 &input_[0], de, numIn, global_learn_rate);
     }
 
 }
@@ -255,38 +415,129 @@ Float MNN_RBM::contrastiveDivergence(const Float* input, size_t numSteps, Float
 {
     copyInput_(input);
 
+    return contrastiveDivergence_(&input_[0], &output_[0], &dataInput_[0], &dataOutput_[0],
+                                  1, numSteps, learn_rate);
+}
+
+MNN_TEMPLATE
+Float MNN_RBM::contrastiveDivergenceBatch(
+        const Float* input, size_t batchSize, size_t numSteps, Float learn_rate)
+{
+    if (batchSize == 0)
+        return 0.;
+
+    const size_t numIn = input_.size(),
+                 numOut = output_.size();
+    batchInput_.resize(batchSize * numIn);
+    batchOutput_.resize(batchSize * numOut);
+    batchDataInput_.resize(batchSize * numIn);
+    batchDataOutput_.resize(batchSize * numOut);
+
+    // copy input, with bias cell
+    const size_t numData = numIn - (biasCell_ ? 1 : 0);
+    for (size_t b = 0; b < batchSize; ++b, input += numData)
+    {
+        Float* v = &batchInput_[b * numIn];
+        std::copy(input, input + numData, v);
+        if (biasCell_)
+            v[numData] = 1;
+    }
+
+    return contrastiveDivergence_(&batchInput_[0], &batchOutput_[0],
+                                  &batchDataInput_[0], &batchDataOutput_[0],
+                                  batchSize, numSteps, learn_rate);
+}
+
+MNN_TEMPLATE
+Float MNN_RBM::contrastiveDivergence_(Float* v, Float* h, Float* v0, Float* h0,
+                                      size_t num, size_t numSteps, Float learn_rate)
+{
+    if (persistent_)
+        return persistentDivergence_(v, h, v0, h0, num, numSteps, learn_rate);
+
+    const size_t numV = num * input_.size(),
+                 numH = num * output_.size();
+
     // -- CD1 --
     if (numSteps <= 1)
     {
-        propUp_();
-        makeBinaryOutput_();
-        getCorrelation_(&correlationData_[0]);
-        propDown_();
-        getCorrelation_(&correlationModel_[0]);
+        propUp_(v, h, num);
+        makeBinary_(h, numH);
+        std::copy(v, v + numV, v0);
+        std::copy(h, h + numH, h0);
+        propDown_(h, v, num);
         // train weights with correlation error
-        return trainCorrelation_(learn_rate);
+        return trainCorrelation_(v0, h0, v, h, num, learn_rate);
     }
 
     // -- CD with n > 1 --
 
     for (size_t i = 1; i < numSteps; ++i)
     {
-        propUp_();
-        makeBinaryOutput_();
+        propUp_(v, h, num);
+        makeBinary_(h, numH);
         if (i == 1)
-            getCorrelation_(&correlationData_[0]);
+        {
+            std::copy(v, v + numV, v0);
+            std::copy(h, h + numH, h0);
+        }
 
-        propDown_();
-        makeBinaryInput_();
+        propDown_(h, v, num);
+        makeBinary_(v, numV);
     }
 
     // last CD step uses probabilities instead of binary states
-    propUp_();
-    propDown_();
-    getCorrelation_(&correlationModel_[0]);
+    propUp_(v, h, num);
+    propDown_(h, v, num);
 
     // train weights with correlation error
-    return trainCorrelation_(learn_rate);
+    return trainCorrelation_(v0, h0, v, h, num, learn_rate);
+}
+
+MNN_TEMPLATE
+Float MNN_RBM::persistentDivergence_(Float* v, Float* h, Float* v0, Float* h0,
+                                     size_t num, size_t numSteps, Float learn_rate)
+{
+    const size_t numV = num * input_.size(),
+                 numH = num * output_.size();
+
+    // positive phase from the data
+    propUp_(v, h, num);
+    makeBinary_(h, numH);
+    std::copy(v, v + numV, v0);
+    std::copy(h, h + numH, h0);
+
+    // (re-)start the chains at the data
+    if (fantasy_.size() != numV)
+        fantasy_.assign(v0, v0 + numV);
+
+    // negative phase continues the chains
+    std::copy(fantasy_.begin(), fantasy_.end(), v);
+    for (size_t i = 0; i < std::max(numSteps, size_t(1)); ++i)
+    {
+        propUp_(v, h, num);
+        makeBinary_(h, numH);
+        propDown_(h, v, num);
+        makeBinary_(v, numV);
+        setBiasCells_(v, num);
+    }
+    std::copy(v, v + numV, fantasy_.begin());
+
+    // model statistics use the hidden probabilities
+    propUp_(v, h, num);
+
+    // train weights with correlation error
+    return trainCorrelation_(v0, h0, v, h, num, learn_rate);
+}
+
+MNN_TEMPLATE
+void MNN_RBM::setBiasCells_(Float* v, size_t num) const
+{
+    if (!biasCell_)
+        return;
+    const size_t numIn = input_.size();
+    for (size_t b = 0; b < num; ++b)
+        v[b * numIn + numIn - 1] = 1;
 }
 
 MNN_TEMPLATE
@@ -300,35 +551,53 @@ Float MNN_RBM::compareInput(const Float* input) const
 }
 
 MNN_TEMPLATE
-Float MNN_RBM::trainCorrelation_(Float learn_rate)
+Float MNN_RBM::trainCorrelation_(const Float* v0, const Float* h0,
+                                 const Float* v, const Float* h,
+                                 size_t num, Float learn_rate)
 {
     if (input_.empty() || output_.empty())
         return 0.;
 
     learn_rate *= learnRate_;
+    const bool doLearn = learn_rate > 0.;
+    if (doLearn)
+        optimizer_->nextStep();
+
+    const size_t numIn = input_.size(),
+                 numOut = output_.size();
+    const Float scale = Float(1) / num;
     Float err_sum = 0.,
-          *w = &weight_[0],
-          *pd = &prevDelta_[0],
-          *cd = &correlationData_[0],
-          *cm = &correlationModel_[0];
-    for (size_t j = 0; j < output_.size(); ++j)
-    for (size_t i = 0; i < input_.size(); ++i, ++w, ++pd, ++cd, ++cm)
+          *w = doLearn ? weight_.data() : nullptr,
+          *g = &gradient_[0];
+    for (size_t o = 0; o < numOut; ++o)
     {
-        const Float de = *cd - *cm;
-        err_sum += std::abs(de);
+        for (size_t i = 0; i < numIn; ++i)
+            g[i] = 0;
 
-        if (learn_rate > 0.)
+        // data minus model correlation of this output, summed over the batch
+        for (size_t b = 0; b < num; ++b)
         {
-            *pd = momentum_ * *pd
-                + learn_rate * de;
-            *w += *pd;
-
-            //if (std::abs(*w) > 5.)
-            //    *w *= 0.9999;
+            const Float hd = h0[b * numOut + o],
+                        hm = h[b * numOut + o],
+                        *vd = v0 + b * numIn,
+                        *vm = v + b * numIn;
+            for (size_t i = 0; i < numIn; ++i)
+            {
+                const Float d = vd[i] * hd - vm[i] * hm;
+                g[i] += d;
+                err_sum += std::abs(d);
+            }
         }
+
+        if (num > 1)
+            for (size_t i = 0; i < numIn; ++i)
+                g[i] *= scale;
+
+        if (doLearn)
+            optimizer_->update(w + o * numIn, o * numIn, g, numIn, learn_rate);
     }
 
-    return err_sum / (input_.size() * output_.size());
+    return err_sum / (num * numIn * numOut);
 }
 
 
@@ -340,63 +609,34 @@ void MNN_RBM::copyInput_(const Float* input)
         for (auto i = input_.begin(); i != input_.end(); ++i, ++input)
             *i = *input;
     else
+    {
         for (size_t i=0; i<input_.size()-1; ++i, ++input)
             input_[i] = *input;
+        // propDown_() overwrites the bias cell
+        input_.back() = 1;
+    }
 }
 
 
 MNN_TEMPLATE
-void MNN_RBM::getCorrelation_(Float* matrix) const
+void MNN_RBM::propUp_(const Float* v, Float* h, size_t num) const
 {
-    for (auto j : output_)
-        for (auto i : input_)
-            *matrix++ = i * j;
+    DenseMatrix::fprop_batch<Float, ActFunc>(
+                v, h, weight_.constData(), input_.size(), output_.size(), num);
 }
 
-
-
-
-
 MNN_TEMPLATE
-void MNN_RBM::propUp_()
+void MNN_RBM::propDown_(const Float* h, Float* v, size_t num) const
 {
-    Float* w = &weight_[0];
-
-    for (auto o = output_.begin(); o != output_.end(); ++o)
-    {
-        Float sum = 0;
-        for (auto i = input_.begin(); i != input_.end(); ++i, ++w)
-        {
-            sum += *i * *w;
-        }
-
-        *o = ActFunc::activation(sum);
-    }
-}
-
-MNN_TEMPLATE
-void MNN_RBM::propDown_()
-{
-    for (size_t i = 0; i < input_.size(); ++i)
-    {
-        Float sum = 0;
-        for (size_t j = 0; j < output_.size(); ++j)
-        {
-            sum += output_[j] * weight_[j * input_.size() + i];
-        }
-
-        input_[i] = ActFunc::activation(sum);
-    }
+    // the weights are the transposed matrix of propUp_()
+    DenseMatrix::fprop_transpose_batch<Float, ActFunc>(
+                h, v, weight_.constData(), output_.size(), input_.size(), num);
 }
 
 MNN_TEMPLATE
 void MNN_RBM::makeBinary_(Float* states, size_t num)
 {
-    for (size_t i=0; i<num; ++i, ++states)
-    {
-        *states = *states > rnd(Float(0), Float(1))
-                ? Float(1) : Float(0);
-    }
+    Random::local().bernoulli(states, num);
 }
 
 
@@ -414,17 +654,33 @@ Float MNN_RBM::getWeightAverage() const
 }
 
 
+MNN_TEMPLATE
+void MNN_RBM::getMemoryUsage(MemoryUsage& usage) const
+{
+    usage.parameters += weight_.size() * sizeof(Float);
+    usage.state += optimizer_->stateBytes() + fantasy_.size() * sizeof(Float);
+    usage.activations += (input_.size() + output_.size()) * sizeof(Float);
+    usage.scratch += (dataInput_.size() + dataOutput_.size() + gradient_.size()
+                      + batchInput_.size() + batchOutput_.size()
+                      + batchDataInput_.size() + batchDataOutput_.size()) * sizeof(Float);
+}
+
 MNN_TEMPLATE
 void MNN_RBM::info(std::ostream &out, const std::string& pf) const
 {
     out <<         pf << "name       : " << name()
         << "\n" << pf << "learnrate  : " << learnRate_
-        << "\n" << pf << "momentum   : " << momentum_
-        << "\n" << pf << "activation : " << ActFunc::static_name()
+        << "\n" << pf << "momentum   : " << momentum()
+        << "\n" << pf << "optimizer  : ";
+    optimizer_->info(out);
+    out << "\n" << pf << "activation : " << ActFunc::static_name()
         << "\n" << pf << "inputs     : " << numIn()
             << (biasCell_ ? " (+1 bias)" : "")
-        << "\n" << pf << "outputs    : " << numOut()
-        << "\n" << pf << "parameters : " << numParameters()
+        << "\n" << pf << "outputs    : " << numOut();
+    if (persistent_)
+        out << "\n" << pf << "chains     : " << numPersistentChains();
+    out << "\n" << pf << "parameters : " << numParameters()
+        << "\n" << pf << "memory     : " << this->memoryUsage()
         << "\n";
 }
 
@@ -15,6 +15,8 @@
 #include <cmath>
 #include <cassert>
 #include <vector>
+#include <algorithm>
+#include <typeinfo>
 #include <iostream>
 
 #include "layer.h"
@@ -26,6 +28,7 @@ template <typename Float>
 class StackParallel
         : public Layer<Float>
         , public SetMomentumInterface<Float>
+        , public SetOptimizerInterface<Float>
         , public SetDropOutInterface<Float>
 {
     public:
@@ -46,6 +49,11 @@ class StackParallel
     /** Sets momentum for ALL layers */
     virtual void setMomentum(Float m) override;
 
+    // --------- OptimizerInterface ----------
+
+    /** Sets a copy of the optimizer for ALL layers */
+    virtual void setOptimizer(const Optimizer<Float>& opt) override;
+
     // --------- DropOutInterface ------------
 
     /** Sets dropout mode for ALL layers */
@@ -72,6 +80,9 @@ class StackParallel
         { return layer_.front()->weights(); }
     virtual void setWeight(size_t input, size_t output, Float w) override
         { layer_.front()->setWeight(input, output, w); }
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>&) override;
+    virtual void setLean(bool lean) override;
+    virtual void releaseTrainingState() override;
 
     // ------- layer interface ---------------
 
@@ -100,6 +111,9 @@ class StackParallel
     // ------- propagation -------------------
 
     virtual void fprop(const Float * input, Float * output) override;
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const override;
+    virtual size_t workspaceSize() const override;
 
     virtual void bprop(const Float * error, Float * error_output = 0,
                        Float global_learn_rate = 1) override;
@@ -110,6 +124,7 @@ class StackParallel
     virtual const char * id() const override { return static_id(); }
     virtual const char * name() const override { return "StackParallel"; }
     virtual size_t numParameters() const override;
+    virtual void getMemoryUsage(MemoryUsage&) const override;
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const override;
     virtual void dump(std::ostream &out = std::cout) const override;
@@ -120,6 +135,8 @@ class StackParallel
 
     virtual void serialize(std::ostream&) const override;
     virtual void deserialize(std::istream&) override;
+    virtual void serializeBinary(BinaryWriter&) const override;
+    virtual void deserializeBinary(BinaryReader&) override;
 
 protected:
 
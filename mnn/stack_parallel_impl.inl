@@ -32,6 +32,19 @@ StackParallel<Float>& MNN_STACKPARALLEL::operator = (const Layer<Float>& layer)
     if (!net)
         return *this;
 
+    // copy in place if all layer types match,
+    // so the parameter memory is kept (see ParameterArena)
+    bool match = layer_.size() == net->layer_.size();
+    for (size_t i = 0; match && i < layer_.size(); ++i)
+        match = typeid(*layer_[i]) == typeid(*net->layer_[i]);
+    if (match)
+    {
+        for (size_t i = 0; i < layer_.size(); ++i)
+            *layer_[i] = *net->layer_[i];
+        resizeBuffers_();
+        return *this;
+    }
+
     clearLayers();
 
     for (size_t i = 0; i < net->numLayer(); ++i)
@@ -89,6 +102,38 @@ void MNN_STACKPARALLEL::deserialize(std::istream& s)
     resizeBuffers_();
 }
 
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::serializeBinary(BinaryWriter& w) const
+{
+    w.beginLayer(id(), "", 1);
+    // dimension
+    w.writeUInt(numLayer());
+    // each layer
+    for (auto l : layer_)
+        l->serializeBinary(w);
+    w.endLayer();
+}
+
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::deserializeBinary(BinaryReader& r)
+{
+    const uint32_t ver = r.beginLayer(id());
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in " << name());
+
+    // dimension
+    const size_t numLay = size_t(r.readUInt());
+    if (numLay != numLayer())
+        MNN_EXCEPTION("Number of layers does not match in " << name()
+                      << ", expected " << numLayer() << ", found " << numLay);
+    // each layer
+    for (auto l : layer_)
+        l->deserializeBinary(r);
+    r.endLayer();
+
+    resizeBuffers_();
+}
+
 
 
 // ----------- dropout & momentum -------------
@@ -117,6 +162,14 @@ void MNN_STACKPARALLEL::setMomentum(Float m)
             d->setMomentum(m);
 }
 
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::setOptimizer(const Optimizer<Float>& opt)
+{
+    for (auto l : layer_)
+        if (auto d = dynamic_cast<SetOptimizerInterface<Float>*>(l))
+            d->setOptimizer(opt);
+}
+
 
 // ----------- nn interface --------------
 
@@ -160,6 +213,27 @@ void MNN_STACKPARALLEL::brainwash(Float amp)
         l->brainwash(amp);
 }
 
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    for (auto l : layer_)
+        l->getParameterBlocks(blocks);
+}
+
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::setLean(bool lean)
+{
+    for (auto l : layer_)
+        l->setLean(lean);
+}
+
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::releaseTrainingState()
+{
+    for (auto l : layer_)
+        l->releaseTrainingState();
+}
+
 // ----------- layer interface -----------
 
 MNN_TEMPLATE
@@ -233,6 +307,28 @@ void MNN_STACKPARALLEL::fprop(const Float * input, Float * output)
         *output = *i;
 }
 
+MNN_TEMPLATE
+size_t MNN_STACKPARALLEL::workspaceSize() const
+{
+    size_t num = 0;
+    for (auto l : layer_)
+        num = std::max(num, l->workspaceSize());
+    return num;
+}
+
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::infer(const Float * input, Float * output,
+                              Workspace<Float>& workspace) const
+{
+    // each layer writes it's part of the output directly
+    for (auto l : layer_)
+    {
+        l->infer(input, output, workspace);
+        input += l->numIn();
+        output += l->numOut();
+    }
+}
+
 
 MNN_TEMPLATE
 void MNN_STACKPARALLEL::bprop(const Float * error, Float * error_output,
@@ -273,6 +369,14 @@ size_t MNN_STACKPARALLEL::numParameters() const
     return num;
 }
 
+MNN_TEMPLATE
+void MNN_STACKPARALLEL::getMemoryUsage(MemoryUsage& usage) const
+{
+    usage.activations += bufferOut_.size() * sizeof(Float);
+    for (auto l : layer_)
+        l->getMemoryUsage(usage);
+}
+
 MNN_TEMPLATE
 void MNN_STACKPARALLEL::info(std::ostream &out, const std::string& pf) const
 {
@@ -287,6 +391,7 @@ void MNN_STACKPARALLEL::info(std::ostream &out, const std::string& pf) const
             out << " | " << layer_[i]->numIn() << "-" << layer_[i]->numOut();
     }
     out << "\n" << pf << "parameters: " << numParameters()
+        << "\n" << pf << "memory    : " << this->memoryUsage()
         << "\n";
     size_t k = 1;
     for (auto l = layer_.begin(); l != layer_.end(); ++l, ++k)
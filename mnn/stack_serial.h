@@ -10,6 +10,9 @@
 
 #include <cmath>
 #include <vector>
+#include <algorithm>
+#include <typeinfo>
+#include <memory>
 #include <iostream>
 
 #include "layer.h"
@@ -21,6 +24,7 @@ template <typename Float>
 class StackSerial
         : public Layer<Float>
         , public SetMomentumInterface<Float>
+        , public SetOptimizerInterface<Float>
         , public SetDropOutInterface<Float>
         , public SetSoftmaxInterface
 {
@@ -42,6 +46,11 @@ class StackSerial
     /** Sets momentum for ALL layers */
     virtual void setMomentum(Float m) override;
 
+    // --------- OptimizerInterface ----------
+
+    /** Sets a copy of the optimizer for ALL layers */
+    virtual void setOptimizer(const Optimizer<Float>& opt) override;
+
     // --------- DropOutInterface ------------
 
     /** Sets dropout mode for ALL layers */
@@ -73,6 +82,9 @@ class StackSerial
         { return layer_.front()->weights(); }
     virtual void setWeight(size_t input, size_t output, Float w) override
         { layer_.front()->setWeight(input, output, w); }
+    virtual void getParameterBlocks(std::vector<ParameterBlock<Float>>&) override;
+    virtual void setLean(bool lean) override;
+    virtual void releaseTrainingState() override;
 
 	// ------- layer interface ---------------
 
@@ -92,6 +104,15 @@ class StackSerial
         has changed it's size. */
     void updateLayers() { resizeBuffers_(); }
 
+    /** Lets each layer write it's output directly into the input
+        of the next layer, if supported by both (default).
+        The activations then exist only once and are only consistent
+        between fprop() and bprop() of the stack.
+        Must be disabled when layers are propagated separately,
+        e.g. on different threads in a Pipeline. */
+    void setShareActivations(bool enable);
+    bool shareActivations() const { return shareActivations_; }
+
     /** Returns the @p index'th layer */
     const Layer<Float>* layer(size_t index) const { return layer_[index]; }
 
@@ -101,6 +122,12 @@ class StackSerial
 	// ------- propagation -------------------
 
     virtual void fprop(const Float * input, Float * output) override;
+    virtual void infer(const Float * input, Float * output,
+                       Workspace<Float>& workspace) const override;
+    virtual size_t workspaceSize() const override;
+    virtual void inferBatch(const Float * input, Float * output, size_t num,
+                            Workspace<Float>& workspace) const override;
+    virtual size_t workspaceSizeBatch(size_t num) const override;
 
     virtual void bprop(const Float * error, Float * error_output = 0,
                        Float global_learn_rate = 1) override;
@@ -111,6 +138,7 @@ class StackSerial
     virtual const char * id() const override { return static_id(); }
     virtual const char * name() const override { return "StackSerial"; }
     virtual size_t numParameters() const override;
+    virtual void getMemoryUsage(MemoryUsage&) const override;
     virtual void info(std::ostream &out = std::cout,
                       const std::string& postFix = "") const override;
     virtual void dump(std::ostream &out = std::cout) const override;
@@ -121,13 +149,22 @@ class StackSerial
 
     virtual void serialize(std::ostream&) const override;
     virtual void deserialize(std::istream&) override;
+    virtual void serializeBinary(BinaryWriter&) const override;
+    virtual void deserializeBinary(BinaryReader&) override;
 
 protected:
 
 	void resizeBuffers_();
 
-	/** intermediate buffers */
-	std::vector<std::vector<Float> > buffer_;
+    /** Activations between the layers.
+        Where supported, a layer's output and the next layer's
+        input are stored here, see Layer::setInputStorage() */
+    std::shared_ptr<std::vector<Float>> activation_;
+    /** Output of each layer except the last, within activation_ */
+    std::vector<Float*> actPtr_;
+    /** Two error buffers for bprop(), used alternately */
+    std::vector<Float> error_;
+    bool shareActivations_;
 
 	/** inidividual layers */
 	std::vector<Layer<Float>*> layer_;
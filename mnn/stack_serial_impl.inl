@@ -11,6 +11,7 @@
 
 MNN_TEMPLATE
 MNN_STACKSERIAL::StackSerial()
+    : shareActivations_ (true)
 {
 
 }
@@ -28,6 +29,19 @@ StackSerial<Float>& MNN_STACKSERIAL::operator = (const Layer<Float>& layer)
     if (!net)
         return *this;
 
+    // copy in place if all layer types match,
+    // so the parameter memory is kept (see ParameterArena)
+    bool match = layer_.size() == net->layer_.size();
+    for (size_t i = 0; match && i < layer_.size(); ++i)
+        match = typeid(*layer_[i]) == typeid(*net->layer_[i]);
+    if (match)
+    {
+        for (size_t i = 0; i < layer_.size(); ++i)
+            *layer_[i] = *net->layer_[i];
+        resizeBuffers_();
+        return *this;
+    }
+
     clearLayers();
 
     for (size_t i = 0; i < net->numLayer(); ++i)
@@ -85,6 +99,38 @@ void MNN_STACKSERIAL::deserialize(std::istream& s)
     resizeBuffers_();
 }
 
+MNN_TEMPLATE
+void MNN_STACKSERIAL::serializeBinary(BinaryWriter& w) const
+{
+    w.beginLayer(id(), "", 1);
+    // dimension
+    w.writeUInt(numLayer());
+    // each layer
+    for (auto l : layer_)
+        l->serializeBinary(w);
+    w.endLayer();
+}
+
+MNN_TEMPLATE
+void MNN_STACKSERIAL::deserializeBinary(BinaryReader& r)
+{
+    const uint32_t ver = r.beginLayer(id());
+    if (ver > 1)
+        MNN_EXCEPTION("Wrong version in " << name());
+
+    // dimension
+    const size_t numLay = size_t(r.readUInt());
+    if (numLay != numLayer())
+        MNN_EXCEPTION("Number of layers does not match in " << name()
+                      << ", expected " << numLayer() << ", found " << numLay);
+    // each layer
+    for (auto l : layer_)
+        l->deserializeBinary(r);
+    r.endLayer();
+
+    resizeBuffers_();
+}
+
 // ----------- dropout & momentum -------------
 
 MNN_TEMPLATE
@@ -111,6 +157,14 @@ void MNN_STACKSERIAL::setMomentum(Float m)
             d->setMomentum(m);
 }
 
+MNN_TEMPLATE
+void MNN_STACKSERIAL::setOptimizer(const Optimizer<Float>& opt)
+{
+    for (auto l : layer_)
+        if (auto d = dynamic_cast<SetOptimizerInterface<Float>*>(l))
+            d->setOptimizer(opt);
+}
+
 
 MNN_TEMPLATE
 void MNN_STACKSERIAL::setSoftmax(bool e)
@@ -168,6 +222,27 @@ void MNN_STACKSERIAL::brainwash(Float amp)
         l->brainwash(amp);
 }
 
+MNN_TEMPLATE
+void MNN_STACKSERIAL::getParameterBlocks(std::vector<ParameterBlock<Float>>& blocks)
+{
+    for (auto l : layer_)
+        l->getParameterBlocks(blocks);
+}
+
+MNN_TEMPLATE
+void MNN_STACKSERIAL::setLean(bool lean)
+{
+    for (auto l : layer_)
+        l->setLean(lean);
+}
+
+MNN_TEMPLATE
+void MNN_STACKSERIAL::releaseTrainingState()
+{
+    for (auto l : layer_)
+        l->releaseTrainingState();
+}
+
 // ----------- layer interface -----------
 
 MNN_TEMPLATE
@@ -202,32 +277,61 @@ void MNN_STACKSERIAL::insert(size_t index, Layer<Float> * layer)
     resizeBuffers_();
 }
 
+MNN_TEMPLATE
+void MNN_STACKSERIAL::setShareActivations(bool enable)
+{
+    shareActivations_ = enable;
+    resizeBuffers_();
+}
+
 MNN_TEMPLATE
 void MNN_STACKSERIAL::resizeBuffers_()
 {
-	{	// clear buffer (completely)
-        std::vector<std::vector<Float>> tmp;
-		tmp.swap( buffer_ );
-	}
+    activation_.reset();
+    actPtr_.clear();
+    {	// clear buffer (completely)
+        std::vector<Float> tmp;
+        tmp.swap( error_ );
+    }
 
     if (layer_.size()<2)
         return;
 
-	buffer_.resize(layer_.size()-1);
-
+    size_t num = 0, maxWidth = 0;
     for (size_t i = 0; i < layer_.size(); ++i)
 	{
 		// resize layer if no fit with previous layer
         if (i > 0 && layer_[i]->numIn() != layer_[i-1]->numOut())
             layer_[i]->resize(layer_[i-1]->numOut(), layer_[i]->numOut());
 
-        // alloc immediate buffer
-        if (i < buffer_.size())
-            buffer_[i]. resize(layer_[i]->numOut());
+        if (i + 1 < layer_.size())
+        {
+            num += layer_[i]->numOut();
+            maxWidth = std::max(maxWidth, layer_[i]->numOut());
+        }
 	}
 
-//	for (auto b = buffer_.begin(); b != buffer_.end(); ++b)
-//		std::cout << "buffer: " << b->size() << "\n";
+    // one continuous block for the activations between layers
+    activation_ = std::make_shared<std::vector<Float>>(num);
+    Float* p = activation_->data();
+    for (size_t i = 0; i + 1 < layer_.size(); ++i)
+    {
+        actPtr_.push_back(p);
+        p += layer_[i]->numOut();
+    }
+
+    // let each layer's output be the next layer's input
+    for (size_t i = 0; i < layer_.size(); ++i)
+        layer_[i]->detachStorage();
+    if (shareActivations_)
+        for (size_t i = 0; i + 1 < layer_.size(); ++i)
+        {
+            layer_[i]->setOutputStorage(actPtr_[i], activation_);
+            layer_[i+1]->setInputStorage(actPtr_[i], activation_);
+        }
+
+    // two alternating error buffers
+    error_.resize(2 * maxWidth);
 }
 
 
@@ -246,16 +350,112 @@ void MNN_STACKSERIAL::fprop(const Float * input, Float * output)
 	}
 
 	// fprob first layer
-	layer_[0]->fprop(input, &buffer_[0][0]);
+	layer_[0]->fprop(input, actPtr_[0]);
 
 	// fprob hidden layers
 	for (size_t i = 1; i<layer_.size()-1; ++i)
 	{
-		layer_[i]->fprop(&buffer_[i-1][0], &buffer_[i][0]);
+		layer_[i]->fprop(actPtr_[i-1], actPtr_[i]);
 	}
 
 	// fprob last layer
-	layer_[layer_.size()-1]->fprop(&buffer_[buffer_.size()-1][0], output);
+	layer_[layer_.size()-1]->fprop(actPtr_[actPtr_.size()-1], output);
+}
+
+MNN_TEMPLATE
+size_t MNN_STACKSERIAL::workspaceSize() const
+{
+    size_t maxWidth = 0, maxLayer = 0;
+    for (size_t i = 0; i<layer_.size(); ++i)
+    {
+        if (i + 1 < layer_.size())
+            maxWidth = std::max(maxWidth, layer_[i]->numOut());
+        maxLayer = std::max(maxLayer, layer_[i]->workspaceSize());
+    }
+    // two intermediate buffers + space for the layers
+    return 2 * maxWidth + maxLayer;
+}
+
+MNN_TEMPLATE
+void MNN_STACKSERIAL::infer(const Float * input, Float * output,
+                            Workspace<Float>& workspace) const
+{
+    if (layer_.empty()) return;
+
+    if (layer_.size()==1)
+    {
+        layer_[0]->infer(input, output, workspace);
+        return;
+    }
+
+    const size_t mark = workspace.mark();
+
+    // ping-pong between two buffers
+    size_t maxWidth = 0;
+    for (size_t i = 0; i<layer_.size()-1; ++i)
+        maxWidth = std::max(maxWidth, layer_[i]->numOut());
+    Float * cur = workspace.allocate(maxWidth),
+          * next = workspace.allocate(maxWidth);
+
+    layer_[0]->infer(input, cur, workspace);
+
+    for (size_t i = 1; i<layer_.size()-1; ++i)
+    {
+        layer_[i]->infer(cur, next, workspace);
+        std::swap(cur, next);
+    }
+
+    layer_[layer_.size()-1]->infer(cur, output, workspace);
+
+    workspace.release(mark);
+}
+
+MNN_TEMPLATE
+size_t MNN_STACKSERIAL::workspaceSizeBatch(size_t num) const
+{
+    size_t maxWidth = 0, maxLayer = 0;
+    for (size_t i = 0; i<layer_.size(); ++i)
+    {
+        if (i + 1 < layer_.size())
+            maxWidth = std::max(maxWidth, layer_[i]->numOut());
+        maxLayer = std::max(maxLayer, layer_[i]->workspaceSizeBatch(num));
+    }
+    // two intermediate batches + space for the layers
+    return 2 * maxWidth * num + maxLayer;
+}
+
+MNN_TEMPLATE
+void MNN_STACKSERIAL::inferBatch(const Float * input, Float * output, size_t num,
+                                 Workspace<Float>& workspace) const
+{
+    if (layer_.empty()) return;
+
+    if (layer_.size()==1)
+    {
+        layer_[0]->inferBatch(input, output, num, workspace);
+        return;
+    }
+
+    const size_t mark = workspace.mark();
+
+    // ping-pong between two batches
+    size_t maxWidth = 0;
+    for (size_t i = 0; i<layer_.size()-1; ++i)
+        maxWidth = std::max(maxWidth, layer_[i]->numOut());
+    Float * cur = workspace.allocate(maxWidth * num),
+          * next = workspace.allocate(maxWidth * num);
+
+    layer_[0]->inferBatch(input, cur, num, workspace);
+
+    for (size_t i = 1; i<layer_.size()-1; ++i)
+    {
+        layer_[i]->inferBatch(cur, next, num, workspace);
+        std::swap(cur, next);
+    }
+
+    layer_[layer_.size()-1]->inferBatch(cur, output, num, workspace);
+
+    workspace.release(mark);
 }
 
 
@@ -273,19 +473,22 @@ void MNN_STACKSERIAL::bprop(const Float * error, Float * error_output,
 		return;
 	}
 
+    // ping-pong between the two error buffers
+    Float * err = &error_[0],
+          * errNext = &error_[error_.size() / 2];
+
 	// bprob last layer
-    layer_[layer_.size()-1]->bprop(
-                error, &buffer_[buffer_.size()-1][0], global_learn_rate);
+    layer_[layer_.size()-1]->bprop(error, err, global_learn_rate);
 
 	// bprob hidden layers
 	for (size_t i = layer_.size()-2; i > 0; --i)
 	{
-//		std::cout << "bprob layer["<<i<<"] with buffer["<<i<<"] > buffer["<<(i-1)<<"]\n";
-		layer_[i]->bprop(&buffer_[i][0], &buffer_[i-1][0], global_learn_rate);
+		layer_[i]->bprop(err, errNext, global_learn_rate);
+        std::swap(err, errNext);
 	}
 
 	// bprob first layer
-	layer_[0]->bprop(&buffer_[0][0], error_output, global_learn_rate);
+	layer_[0]->bprop(err, error_output, global_learn_rate);
 }
 
 
@@ -311,6 +514,16 @@ size_t MNN_STACKSERIAL::numParameters() const
     return num;
 }
 
+MNN_TEMPLATE
+void MNN_STACKSERIAL::getMemoryUsage(MemoryUsage& usage) const
+{
+    if (activation_)
+        usage.activations += activation_->size() * sizeof(Float);
+    usage.scratch += error_.size() * sizeof(Float);
+    for (auto l : layer_)
+        l->getMemoryUsage(usage);
+}
+
 MNN_TEMPLATE
 void MNN_STACKSERIAL::info(std::ostream &out, const std::string& pf) const
 {
@@ -325,6 +538,7 @@ void MNN_STACKSERIAL::info(std::ostream &out, const std::string& pf) const
             out << " - " << l->numOut();
     }
     out << "\n" << pf << "parameters: " << numParameters()
+        << "\n" << pf << "memory    : " << this->memoryUsage()
         << "\n";
 	size_t k = 1;
 	for (auto l = layer_.begin(); l != layer_.end(); ++l, ++k)
@@ -0,0 +1,308 @@
+/** @file text_io.h
+
+    @brief Fast reading of numbers from text streams
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_TEXT_IO_H
+#define MNNSRC_TEXT_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <string>
+#include <sstream>
+#include <locale>
+#include <iostream>
+
+namespace MNN {
+
+/** Parsing of the numbers in text model files.
+
+    operator>> on a std::istream builds a sentry, consults the locale
+    and converts each number through a temporary string, which makes
+    loading large text models slow. readValues() reads the characters
+    straight from the stream buffer and converts most numbers with
+    one exact floating point operation.
+
+    The results are bit-identical to operator>>, which rounds
+    correctly: a number with at most 19 significant digits and
+    a decimal exponent of at most 22 is converted as
+    m * 10^e or m / 10^e in double precision, where both operands
+    are exact, so the single rounding of the operation gives the
+    correctly rounded double. A float is rounded from this double,
+    unless the double lies exactly between two floats, where
+    the second rounding could differ. All other numbers,
+    and all numbers on machines that evaluate floating point
+    in a wider precision, are converted by operator>>.
+*/
+namespace Text
+{
+    /** Converts the @p len characters at @p str, an optional sign,
+        digits with an optional decimal point and an optional exponent,
+        to @p value. Returns false if the number is malformed
+        or can not be converted exactly on the fast path. */
+    template <typename Float>
+    bool parseFast(const char* str, size_t len, Float& value);
+
+    /** Reads @p num whitespace-separated numbers from @p s into @p dst.
+        Same result as calling s >> dst[i] for each value.
+        Sets the failbit of @p s on error, like operator>>. */
+    template <typename Float>
+    void readValues(std::istream& s, Float* dst, size_t num);
+
+    /** Appends the rest of the stream @p s to @p dst.
+        Works on streams that can not seek, e.g. pipes. */
+    inline void readAll(std::istream& s, std::string& dst);
+
+    /** Read-only std::streambuf on a range of memory,
+        which must stay valid while reading. Does not seek. */
+    class MemoryBuf : public std::streambuf
+    {
+    public:
+        MemoryBuf(const char* data, size_t size)
+        {
+            char* p = const_cast<char*>(data);
+            setg(p, p, p + size);
+        }
+    };
+
+} // namespace Text
+
+
+// ------------------ impl ------------------
+
+namespace Text
+{
+    inline bool isSpace_(int c)
+    {
+        return c == ' ' || c == '\n' || c == '\t'
+            || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline bool isNumberChar_(int c)
+    {
+        return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+'
+            || c == 'e' || c == 'E';
+    }
+
+    /** True if any of the 8 bytes at @p p is 'a' or above,
+        e.g. the start of an identifier among numbers */
+    inline bool mayHaveLetter8_(const char* p)
+    {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        // the masked bytes can not carry into their neighbours
+        return ((((w & 0x7f7f7f7f7f7f7f7full) + 0x1f1f1f1f1f1f1f1full) | w)
+                & 0x8080808080808080ull) != 0;
+    }
+
+    /** Exact powers of ten in double */
+    inline double pow10_(int e)
+    {
+        static const double p[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+            1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+            1e21, 1e22 };
+        return p[e];
+    }
+
+    /** Correctly rounded double from the decimal, or false */
+    inline bool parseDouble_(const char* str, size_t len, double& value)
+    {
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD != 0
+        // intermediate results in extended precision round twice
+        (void)str; (void)len; (void)value;
+        return false;
+#else
+        const char* p = str, * end = str + len;
+        bool neg = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            neg = *p++ == '-';
+
+        uint64_t m = 0;
+        int digits = 0, exp10 = 0;
+        bool any = false;
+        // integer part
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            any = true;
+            if (m == 0 && *p == '0')
+                continue;
+            if (++digits > 19)
+                return false;
+            m = m * 10 + uint64_t(*p - '0');
+        }
+        // fraction
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+            {
+                any = true;
+                --exp10;
+                if (m == 0 && *p == '0')
+                    continue;
+                if (++digits > 19)
+                    return false;
+                m = m * 10 + uint64_t(*p - '0');
+            }
+        }
+        if (!any)
+            return false;
+        // exponent
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool eneg = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                eneg = *p++ == '-';
+            if (p == end)
+                return false;
+            int e = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+            {
+                if (e > 10000)
+                    return false;
+                e = e * 10 + (*p - '0');
+            }
+            exp10 += eneg ? -e : e;
+        }
+        if (p != end)
+            return false;
+
+        double d;
+        if (m == 0)
+            d = 0.;
+        else
+        {
+            if (m > (uint64_t(1) << 53) || exp10 < -22 || exp10 > 22)
+                return false;
+            d = exp10 < 0 ? double(m) / pow10_(-exp10)
+                          : double(m) * pow10_(exp10);
+        }
+        value = neg ? -d : d;
+        return true;
+#endif
+    }
+
+    template <>
+    inline bool parseFast<double>(const char* str, size_t len, double& value)
+    {
+        return parseDouble_(str, len, value);
+    }
+
+    template <>
+    inline bool parseFast<float>(const char* str, size_t len, float& value)
+    {
+        double d;
+        if (!parseDouble_(str, len, d))
+            return false;
+        // operator>> flags overflow
+        if (std::abs(d) > double(std::numeric_limits<float>::max()))
+            return false;
+        const float f = float(d);
+        if (double(f) != d)
+        {
+            // a double between two floats rounds like the decimal,
+            // unless it is the exact midpoint
+            const float other = std::nextafter(f, d > double(f)
+                    ? std::numeric_limits<float>::infinity()
+                    : -std::numeric_limits<float>::infinity());
+            if ((double(f) + double(other)) * .5 == d)
+                return false;
+        }
+        value = f;
+        return true;
+    }
+
+    template <typename Float>
+    void readValues(std::istream& s, Float* dst, size_t num)
+    {
+        // the fast path knows only the "C" number format
+        if (s.getloc() != std::locale::classic())
+        {
+            for (size_t i = 0; i < num && s; ++i)
+                s >> dst[i];
+            return;
+        }
+
+        std::streambuf* sb = s.rdbuf();
+        typedef std::char_traits<char> Traits;
+        std::string token;
+        for (size_t i = 0; i < num; ++i)
+        {
+            if (!s.good())
+            {
+                s.setstate(std::ios_base::failbit);
+                return;
+            }
+            // skip whitespace
+            int c = sb->sgetc();
+            while (c != Traits::eof() && isSpace_(c))
+                c = sb->snextc();
+            if (c == Traits::eof())
+            {
+                s.setstate(std::ios_base::eofbit | std::ios_base::failbit);
+                return;
+            }
+            // e.g. 'nan' or 'inf', leave to operator>>
+            if (!isNumberChar_(c))
+            {
+                s >> dst[i];
+                continue;
+            }
+            // collect the number
+            token.clear();
+            while (c != Traits::eof() && isNumberChar_(c))
+            {
+                token.push_back(char(c));
+                c = sb->snextc();
+            }
+            if (c == Traits::eof())
+                s.setstate(std::ios_base::eofbit);
+
+            if (parseFast(token.data(), token.size(), dst[i]))
+                continue;
+
+            // convert the rest the standard way
+            std::istringstream str(token);
+            str.imbue(s.getloc());
+            str >> dst[i];
+            if (str.fail() || str.peek() != Traits::eof())
+            {
+                s.setstate(std::ios_base::failbit);
+                return;
+            }
+        }
+    }
+
+    inline void readAll(std::istream& s, std::string& dst)
+    {
+        // reserve the remaining size of seekable streams
+        std::streambuf* sb = s.rdbuf();
+        const std::streamoff cur = sb->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+        if (cur >= 0)
+        {
+            const std::streamoff end = sb->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+            sb->pubseekpos(cur, std::ios_base::in);
+            if (end > cur)
+                dst.reserve(dst.size() + size_t(end - cur));
+        }
+
+        char buf[1 << 16];
+        while (s.read(buf, sizeof(buf)) || s.gcount())
+            dst.append(buf, size_t(s.gcount()));
+    }
+
+} // namespace Text
+
+} // namespace MNN
+
+#endif // MNNSRC_TEXT_IO_H
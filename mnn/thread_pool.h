@@ -0,0 +1,311 @@
+/** @file thread_pool.h
+
+    @brief Simple persistent worker pool
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_THREAD_POOL_H
+#define MNNSRC_THREAD_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <utility>
+
+namespace MNN {
+
+/** FIFO on a growing ring buffer.
+    Unlike std::deque it does not allocate once it has reached
+    it's maximum size. Not thread-safe. */
+template <typename T>
+class RingQueue
+{
+public:
+
+    RingQueue() : head_(0), size_(0) { }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void push_back(T v)
+    {
+        if (size_ == data_.size())
+            grow_();
+        data_[(head_ + size_) % data_.size()] = std::move(v);
+        ++size_;
+    }
+
+    T& front() { return data_[head_]; }
+
+    void pop_front()
+    {
+        data_[head_] = T();
+        head_ = (head_ + 1) % data_.size();
+        --size_;
+    }
+
+    /** Removes all entries, keeps the memory */
+    void clear()
+    {
+        while (!empty())
+            pop_front();
+        head_ = 0;
+    }
+
+private:
+
+    void grow_()
+    {
+        std::vector<T> tmp(std::max(size_t(16), data_.size() * 2));
+        for (size_t i = 0; i < size_; ++i)
+            tmp[i] = std::move(data_[(head_ + i) % data_.size()]);
+        data_.swap(tmp);
+        head_ = 0;
+    }
+
+    std::vector<T> data_;
+    size_t head_, size_;
+};
+
+
+/** A fixed number of worker threads processing a task queue.
+
+    The threads are created once in the constructor, so the pool
+    can be used for many small jobs per training step without
+    the cost of creating threads. Once the queue has grown to it's
+    working size, parallelFor() does not allocate memory.
+*/
+class ThreadPool
+{
+    ThreadPool(const ThreadPool&) = delete;
+    void operator = (const ThreadPool&) = delete;
+
+public:
+
+    /** Creates @p numThreads workers.
+        If @p numThreads is 0, one worker per core is created. */
+    explicit ThreadPool(size_t numThreads = 0);
+
+    /** Waits for all queued tasks and stops the workers */
+    ~ThreadPool();
+
+    /** Returns the number of worker threads */
+    size_t numThreads() const { return threads_.size(); }
+
+    /** Returns the number of hardware threads (at least 1) */
+    static size_t numCores()
+    {
+        size_t n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    /** Queues @p task for asynchronous execution */
+    void enqueue(std::function<void()> task);
+
+    /** Blocks until the queue is empty and no task is running */
+    void wait();
+
+    /** Calls @p func(index) for each index in [0, @p num) and blocks
+        until all calls have returned.
+        The first exception thrown by @p func is rethrown in the calling thread.
+        @note Must not be called from within a task of the same pool. */
+    template <class Func>
+    void parallelFor(size_t num, const Func& func);
+
+private:
+
+    void run_();
+
+    std::vector<std::thread> threads_;
+    RingQueue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_, condIdle_;
+    size_t numRunning_;
+    bool doStop_;
+};
+
+
+/** Thread-safe FIFO for passing values between threads.
+    pop() blocks until a value is available or the channel is closed. */
+template <typename T>
+class Channel
+{
+public:
+
+    Channel() : closed_(false) { }
+
+    void push(const T& v)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_.push_back(v);
+        }
+        cond_.notify_one();
+    }
+
+    /** Waits for the next value.
+        Returns false if the channel was closed. */
+    bool pop(T& v)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this](){ return closed_ || !queue_.empty(); });
+        if (closed_)
+            return false;
+        v = queue_.front();
+        queue_.pop_front();
+        return true;
+    }
+
+    /** Wakes up all waiting threads, pop() returns false from now on */
+    void close()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cond_.notify_all();
+    }
+
+    /** Removes all values and reopens the channel */
+    void reset()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_.clear();
+        closed_ = false;
+    }
+
+private:
+    RingQueue<T> queue_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool closed_;
+};
+
+
+
+// ------------------------ impl ---------------------------
+
+inline ThreadPool::ThreadPool(size_t numThreads)
+    : numRunning_   (0)
+    , doStop_       (false)
+{
+    if (numThreads == 0)
+        numThreads = numCores();
+    for (size_t i = 0; i < numThreads; ++i)
+        threads_.push_back(std::thread([this](){ run_(); }));
+}
+
+inline ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        doStop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& t : threads_)
+        t.join();
+}
+
+inline void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+inline void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    condIdle_.wait(lock, [this](){ return tasks_.empty() && numRunning_ == 0; });
+}
+
+inline void ThreadPool::run_()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this](){ return doStop_ || !tasks_.empty(); });
+            // finish queue before stopping
+            if (tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++numRunning_;
+        }
+
+        task();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            --numRunning_;
+            if (tasks_.empty() && numRunning_ == 0)
+                condIdle_.notify_all();
+        }
+    }
+}
+
+template <class Func>
+void ThreadPool::parallelFor(size_t num, const Func& func)
+{
+    if (num == 0)
+        return;
+    // no need to wake anybody
+    if (num == 1)
+    {
+        func(0);
+        return;
+    }
+
+    // shared by all tasks, so that each task is small enough
+    // to be stored inside the std::function
+    struct Job
+    {
+        const Func* func;
+        std::mutex mutex;
+        std::condition_variable cond;
+        size_t numLeft;
+        std::exception_ptr error;
+    } job;
+    job.func = &func;
+    job.numLeft = num;
+
+    Job* j = &job;
+    for (size_t i = 0; i < num; ++i)
+    {
+        enqueue([j, i]()
+        {
+            std::exception_ptr e;
+            try { (*j->func)(i); }
+            catch (...) { e = std::current_exception(); }
+
+            std::unique_lock<std::mutex> lock(j->mutex);
+            if (e && !j->error)
+                j->error = e;
+            if (--j->numLeft == 0)
+                j->cond.notify_all();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.cond.wait(lock, [&](){ return job.numLeft == 0; });
+
+    if (job.error)
+        std::rethrow_exception(job.error);
+}
+
+} // namespace MNN
+
+#endif // MNNSRC_THREAD_POOL_H
@@ -0,0 +1,210 @@
+/** @file trainer.h
+
+    @brief Epoch-based training loop with throughput statistics
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_TRAINER_H
+#define MNNSRC_TRAINER_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+#include "layer.h"
+#include "dataset.h"
+#include "stack_serial.h"
+#include "model_averaging.h"
+#include "pipeline.h"
+#include "allocation_counter.h"
+
+namespace MNN {
+
+/** Statistics of one training epoch */
+struct TrainerStats
+{
+    TrainerStats() { clear(); }
+
+    void clear()
+    {
+        epoch = numSamples = numErrors = 0;
+        errorSum = seconds = secondsFprop = secondsBprop = secondsData = 0.;
+    }
+
+    /** Average absolute error per output */
+    double averageError() const { return numSamples ? errorSum / numSamples : 0.; }
+    /** Fraction of samples where the largest output is not the expected one */
+    double errorRate() const { return numSamples ? double(numErrors) / numSamples : 0.; }
+    double samplesPerSecond() const { return seconds > 0. ? numSamples / seconds : 0.; }
+
+    /** Prints a one-line summary */
+    void info(std::ostream& out = std::cout) const
+    {
+        out << "epoch " << epoch
+            << ", samples " << numSamples
+            << ", error " << averageError()
+            << ", wrong " << (errorRate() * 100.) << "%"
+            << ", " << seconds << "s (" << samplesPerSecond() << "/s"
+            << ", fprop " << secondsFprop
+            << "s, bprop " << secondsBprop
+            << "s, data " << secondsData << "s)";
+    }
+
+    size_t epoch, numSamples, numErrors;
+    double errorSum,
+    /** Wall-clock time of the epoch */
+           seconds,
+    /** Time spent in fprop(), bprop() and the data set, summed over threads.
+        fprop and bprop are not measured in pipeline mode. */
+           secondsFprop, secondsBprop, secondsData;
+};
+
+
+enum TrainerMode
+{
+    /** fprop() and bprop() for each sample on the calling thread */
+    TM_SERIAL,
+    /** Each minibatch is split over network replicas,
+        which are averaged afterwards, see ModelAveraging */
+    TM_DATA_PARALLEL,
+    /** Minibatches are streamed through a Pipeline of the layers.
+        Only for StackSerial networks. A minibatch holds at least
+        Pipeline::maxInFlight() micro-batches, so that the stages overlap. */
+    TM_PIPELINE
+};
+
+
+/** Supervised training of a Layer over a DataSetInterface.
+
+    Each epoch visits all samples once in a new random order and
+    processes them in minibatches. In serial and pipeline mode every
+    sample makes one bprop() with the error (expected - output).
+    In data-parallel mode the minibatch is split over the replicas
+    and the trained replicas are averaged after each minibatch
+    (model averaging, not a single step with the averaged gradient).
+
+    The shuffling uses it's own generator, so the sample order only
+    depends on setSeed().
+*/
+template <typename Float>
+class Trainer
+{
+    Trainer(const Trainer&) = delete;
+    void operator = (const Trainer&) = delete;
+
+public:
+
+    /** Called after each epoch and every reportInterval() samples */
+    typedef std::function<void(const TrainerStats&)> ReportFunc;
+
+    /** Neither network nor data set are owned */
+    Trainer(Layer<Float>& net, const DataSetInterface<Float>& data);
+    ~Trainer();
+
+    // ------------ settings -------------
+
+    void setMode(TrainerMode m) { mode_ = m; release_(); }
+    /** Number of replicas in data-parallel mode, 0 = one per core.
+        The pipeline always uses one thread per stage. */
+    void setNumThreads(size_t num) { numThreads_ = num; release_(); }
+    /** Samples per minibatch, see stepSize() */
+    void setBatchSize(size_t num) { batchSize_ = std::max(size_t(1), num); }
+    void setLearnRate(Float lr) { learnRate_ = lr; }
+    void setSeed(uint32_t seed) { rng_.seed(seed); }
+    void setReportFunc(ReportFunc f) { reportFunc_ = f; }
+    /** Report every @p num samples within an epoch, 0 = only at the end */
+    void setReportInterval(size_t num) { reportInterval_ = num; }
+    /** Debug option: throws an MNN::Exception when a training step
+        after the first one allocates heap memory.
+        Needs MNN_DEFINE_ALLOCATION_COUNTER, see allocation_counter.h */
+    void setCheckAllocations(bool enable) { checkAllocations_ = enable; }
+
+    // ------------ getter ---------------
+
+    TrainerMode mode() const { return mode_; }
+    size_t batchSize() const { return batchSize_; }
+    /** Samples per training step. The batchSize(), raised in pipeline mode
+        to fill the pipeline. Valid after the first trainEpoch(). */
+    size_t stepSize() const { return stepSize_; }
+    Float learnRate() const { return learnRate_; }
+    size_t reportInterval() const { return reportInterval_; }
+    bool checkAllocations() const { return checkAllocations_; }
+    size_t numEpochs() const { return epoch_; }
+
+    /** Statistics of the current or last epoch */
+    const TrainerStats& stats() const { return stats_; }
+
+    // ------------ training -------------
+
+    /** Runs @p num epochs */
+    void train(size_t num = 1);
+
+    /** Runs one epoch and returns it's statistics */
+    const TrainerStats& trainEpoch();
+
+    /** Must be called when the network was changed from outside
+        while in data-parallel mode, e.g. after loading weights */
+    void networkChanged();
+
+private:
+
+    typedef std::chrono::steady_clock Clock;
+
+    /** Per-thread accumulators */
+    struct ThreadStats
+    {
+        size_t numSamples, numErrors;
+        double errorSum, fprop, bprop, data;
+        std::vector<Float> output, expected, error;
+    };
+
+    void prepare_();
+    void release_();
+    void trainBatchSerial_(size_t pos, size_t num);
+    void trainBatchParallel_(size_t pos, size_t num);
+    void trainBatchPipeline_(size_t pos, size_t num);
+    /** Trains sample @p index on @p net using buffers of @p ts */
+    void trainSample_(Layer<Float>& net, size_t index, ThreadStats& ts);
+    /** Calculates error into ts.error and gathers stats */
+    void addError_(ThreadStats& ts, const Float* output);
+    void updateStats_();
+
+    static double seconds_(const Clock::time_point& start)
+        { return std::chrono::duration<double>(Clock::now() - start).count(); }
+
+    Layer<Float>& net_;
+    const DataSetInterface<Float>& data_;
+
+    TrainerMode mode_;
+    size_t numThreads_, batchSize_, stepSize_, reportInterval_, epoch_;
+    Float learnRate_;
+    bool checkAllocations_,
+    /** Set after the first step in the current mode */
+         warm_;
+    ReportFunc reportFunc_;
+    std::mt19937 rng_;
+
+    std::vector<size_t> order_;
+    std::vector<ThreadStats> threadStats_;
+    TrainerStats stats_;
+    Clock::time_point epochStart_;
+
+    std::unique_ptr<ModelAveraging<Float>> parallel_;
+    std::unique_ptr<Pipeline<Float>> pipeline_;
+};
+
+#include "trainer_impl.inl"
+
+} // namespace MNN
+
+#endif // MNNSRC_TRAINER_H
@@ -0,0 +1,270 @@
+/** @file trainer_impl.inl
+
+    @brief Trainer implementation
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#define MNN_TEMPLATE template <typename Float>
+#define MNN_TRAINER Trainer<Float>
+
+MNN_TEMPLATE
+MNN_TRAINER::Trainer(Layer<Float>& net, const DataSetInterface<Float>& data)
+    : net_              (net)
+    , data_             (data)
+    , mode_             (TM_SERIAL)
+    , numThreads_       (0)
+    , batchSize_        (1)
+    , stepSize_         (1)
+    , reportInterval_   (0)
+    , epoch_            (0)
+    , learnRate_        (1)
+    , checkAllocations_ (false)
+    , warm_             (false)
+{
+    if (data_.numIn() != net_.numIn() || data_.numOut() != net_.numOut())
+        MNN_EXCEPTION("Data set size " << data_.numIn() << " -> " << data_.numOut()
+                      << " does not match network " << net_.numIn() << " -> "
+                      << net_.numOut() << " in Trainer");
+}
+
+MNN_TEMPLATE
+MNN_TRAINER::~Trainer()
+{
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::release_()
+{
+    parallel_.reset();
+    pipeline_.reset();
+    warm_ = false;
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::networkChanged()
+{
+    if (parallel_)
+        parallel_->broadcast();
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::prepare_()
+{
+    size_t numSlots = 1;
+    stepSize_ = batchSize_;
+    switch (mode_)
+    {
+        case TM_SERIAL: break;
+
+        case TM_DATA_PARALLEL:
+            if (!parallel_)
+                parallel_.reset(new ModelAveraging<Float>(net_, numThreads_));
+            numSlots = parallel_->numReplicas();
+        break;
+
+        case TM_PIPELINE:
+            if (!pipeline_)
+            {
+                auto stack = dynamic_cast<StackSerial<Float>*>(&net_);
+                if (!stack)
+                    MNN_EXCEPTION("Pipeline mode needs a StackSerial in Trainer, got "
+                                  << net_.name());
+                pipeline_.reset(new Pipeline<Float>(*stack));
+            }
+            // input and error are handled on different threads
+            numSlots = 2;
+            // with fewer samples per train() call the stages run one after another
+            stepSize_ = std::max(batchSize_,
+                                 pipeline_->maxInFlight() * pipeline_->microBatchSize());
+        break;
+    }
+
+    threadStats_.resize(numSlots);
+    for (auto& ts : threadStats_)
+    {
+        ts.output.resize(data_.numOut());
+        ts.expected.resize(data_.numOut());
+        ts.error.resize(data_.numOut());
+    }
+
+    if (order_.size() != data_.numSamples())
+    {
+        order_.resize(data_.numSamples());
+        for (size_t i = 0; i < order_.size(); ++i)
+            order_[i] = i;
+    }
+}
+
+
+// -------------------- training ---------------------
+
+MNN_TEMPLATE
+void MNN_TRAINER::train(size_t num)
+{
+    for (size_t i = 0; i < num; ++i)
+        trainEpoch();
+}
+
+MNN_TEMPLATE
+const TrainerStats& MNN_TRAINER::trainEpoch()
+{
+    prepare_();
+
+    std::shuffle(order_.begin(), order_.end(), rng_);
+
+    for (auto& ts : threadStats_)
+    {
+        ts.numSamples = ts.numErrors = 0;
+        ts.errorSum = ts.fprop = ts.bprop = ts.data = 0.;
+    }
+    stats_.clear();
+    stats_.epoch = ++epoch_;
+    epochStart_ = Clock::now();
+
+    size_t nextReport = reportInterval_;
+    for (size_t pos = 0; pos < order_.size(); pos += stepSize_)
+    {
+        const size_t num = std::min(stepSize_, order_.size() - pos);
+
+        AllocationCheck allocs;
+
+        switch (mode_)
+        {
+            case TM_SERIAL: trainBatchSerial_(pos, num); break;
+            case TM_DATA_PARALLEL: trainBatchParallel_(pos, num); break;
+            case TM_PIPELINE: trainBatchPipeline_(pos, num); break;
+        }
+
+        // the first step may still size buffers
+        if (checkAllocations_ && warm_)
+            allocs.check("Trainer step");
+        warm_ = true;
+
+        if (reportInterval_ && pos + num >= nextReport
+                && pos + num < order_.size())
+        {
+            nextReport += reportInterval_;
+            updateStats_();
+            if (reportFunc_)
+                reportFunc_(stats_);
+        }
+    }
+
+    updateStats_();
+    if (reportFunc_)
+        reportFunc_(stats_);
+
+    return stats_;
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::updateStats_()
+{
+    const size_t epoch = stats_.epoch;
+    stats_.clear();
+    stats_.epoch = epoch;
+    for (auto& ts : threadStats_)
+    {
+        stats_.numSamples += ts.numSamples;
+        stats_.numErrors += ts.numErrors;
+        stats_.errorSum += ts.errorSum;
+        stats_.secondsFprop += ts.fprop;
+        stats_.secondsBprop += ts.bprop;
+        stats_.secondsData += ts.data;
+    }
+    stats_.seconds = seconds_(epochStart_);
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::addError_(ThreadStats& ts, const Float* output)
+{
+    const size_t num = ts.error.size();
+    Float sum = 0;
+    size_t maxOut = 0, maxExp = 0;
+    for (size_t i = 0; i < num; ++i)
+    {
+        ts.error[i] = ts.expected[i] - output[i];
+        sum += std::abs(ts.error[i]);
+        if (output[i] > output[maxOut])
+            maxOut = i;
+        if (ts.expected[i] > ts.expected[maxExp])
+            maxExp = i;
+    }
+    if (num)
+        ts.errorSum += sum / num;
+    if (maxOut != maxExp)
+        ++ts.numErrors;
+    ++ts.numSamples;
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::trainSample_(Layer<Float>& net, size_t index, ThreadStats& ts)
+{
+    auto t = Clock::now();
+    const Float* input = data_.input(index);
+    data_.expectedOutput(index, &ts.expected[0]);
+    ts.data += seconds_(t);
+
+    t = Clock::now();
+    net.fprop(input, &ts.output[0]);
+    ts.fprop += seconds_(t);
+
+    addError_(ts, &ts.output[0]);
+
+    t = Clock::now();
+    net.bprop(&ts.error[0], 0, learnRate_);
+    ts.bprop += seconds_(t);
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::trainBatchSerial_(size_t pos, size_t num)
+{
+    for (size_t k = 0; k < num; ++k)
+        trainSample_(net_, order_[pos + k], threadStats_[0]);
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::trainBatchParallel_(size_t pos, size_t num)
+{
+    parallel_->step(num, [this, pos](Layer<Float>& replica, size_t r,
+                                     size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; ++k)
+            trainSample_(replica, order_[pos + k], threadStats_[r]);
+    });
+}
+
+MNN_TEMPLATE
+void MNN_TRAINER::trainBatchPipeline_(size_t pos, size_t num)
+{
+    // input is requested by the first stage, the error by the last stage.
+    // (the lambdas are kept small enough to not allocate in std::function)
+    pipeline_->train(num,
+        [this, pos](size_t k)
+        {
+            ThreadStats& tsIn = threadStats_[0];
+            auto t = Clock::now();
+            const Float* input = data_.input(order_[pos + k]);
+            tsIn.data += seconds_(t);
+            return input;
+        },
+        [this, pos](size_t k, const Float* output, Float* error)
+        {
+            ThreadStats& tsErr = threadStats_[1];
+            auto t = Clock::now();
+            data_.expectedOutput(order_[pos + k], &tsErr.expected[0]);
+            tsErr.data += seconds_(t);
+
+            addError_(tsErr, output);
+            std::copy(tsErr.error.begin(), tsErr.error.end(), error);
+        },
+        learnRate_);
+}
+
+
+#undef MNN_TEMPLATE
+#undef MNN_TRAINER
@@ -0,0 +1,80 @@
+/** @file workspace.h
+
+    @brief Scratch memory for Layer::infer()
+
+    <p>(c) 2026, stefan.berke@modular-audio-graphics.com</p>
+    <p>All rights reserved</p>
+
+    <p>created 10/19/2026</p>
+*/
+
+#ifndef MNNSRC_WORKSPACE_H
+#define MNNSRC_WORKSPACE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "exception.h"
+
+namespace MNN {
+
+/** A linear scratch buffer for intermediate values.
+
+    Memory is handed out in stack order with allocate() and
+    given back with release(mark()). A Workspace is not thread-safe,
+    each thread needs it's own instance. Sized once with
+    Layer::workspaceSize(), a Workspace does not allocate
+    during propagation.
+*/
+template <typename Float>
+class Workspace
+{
+public:
+
+    /** Creates a workspace of @p size Floats */
+    explicit Workspace(size_t size = 0) : buffer_(size), used_(0) { }
+
+    /** Total number of Floats */
+    size_t size() const { return buffer_.size(); }
+
+    /** Number of currently allocated Floats */
+    size_t used() const { return used_; }
+
+    /** Makes sure at least @p size Floats are available.
+        Previously allocated pointers become invalid,
+        so this must only be called between propagations. */
+    void reserve(size_t size)
+    {
+        if (used_)
+            MNN_EXCEPTION("Workspace::reserve() while in use");
+        if (buffer_.size() < size)
+            buffer_.resize(size);
+    }
+
+    /** Returns @p num uninitialized Floats.
+        @throws MNN::Exception if the workspace is too small */
+    Float* allocate(size_t num)
+    {
+        if (used_ + num > buffer_.size())
+            MNN_EXCEPTION("Workspace of size " << buffer_.size()
+                          << " too small, requested " << (used_ + num));
+        Float* p = &buffer_[0] + used_;
+        used_ += num;
+        return p;
+    }
+
+    /** Current allocation position, to be passed to release() */
+    size_t mark() const { return used_; }
+
+    /** Frees everything allocated since mark() returned @p mark */
+    void release(size_t mark) { used_ = mark; }
+
+private:
+
+    std::vector<Float> buffer_;
+    size_t used_;
+};
+
+} // namespace MNN
+
+#endif // MNNSRC_WORKSPACE_H
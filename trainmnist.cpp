@@ -46,16 +46,28 @@ struct TrainMnist::Private
     Private()
         : doTrainCD (false)
         , cdnet     (0)
-    { }
+        , numThreads(1)
+    {
+        // the best few nets, by validation error
+        checkpointer.setKeepLast(3);
+    }
 
     void loadSet();
     void saveAllLayers(const std::string& postfix);
+    /** Saves the net after testPerformance() when error_count is a new low */
+    void saveIfBest();
     void createNet();
     void clearErrorCount();
     void prepareExpectedOutput(std::vector<Float>& v, uint8_t label) const;
-    const Float* getImage(DataSet& set, uint32_t index) const;
+    /** Returns an augmented training image, valid until the next call */
+    const Float* getImage(DataSet& set, uint32_t index);
+    /** Thread-safe version of getImage() */
+    void getImage(const DataSet& set, uint32_t index, Float* output) const;
     void train();
     void trainLabelStep();
+    /** Multi-threaded training with MNN::Trainer in shuffled epochs,
+        numBatch samples per replica and step */
+    void trainEpochs();
     template <class Rbm>
     void trainCDStep(Rbm& rbm);
     template <class Net>
@@ -65,12 +77,16 @@ struct TrainMnist::Private
     /** Gets error and stats, returns label from net */
     template <class Net>
     int getLabelError(const Net& net, int label);
+    /** Returns the index of the largest output, or -1 */
+    int getAnswer(const Float* output, size_t num) const;
+    /** Adds the error of @p answer to the stats */
+    void addLabelError(int answer, int label);
 
     void runInputApproximation();
 
     DataSet trainSet, testSet;
     MNN::StackSerial<Float> net;
-    std::vector<Float> bufIn, bufExp, bufOut, bufErr;
+    std::vector<Float> bufIn, bufExp, bufOut, bufErr, bufImage;
     std::vector<size_t> errorsPerClass;
     Float learnRate,
         error, error_min, error_max, error_sum;
@@ -78,6 +94,13 @@ struct TrainMnist::Private
     int64_t saved_error_count;
     bool doTrainCD;
     MNN::ContrastiveDivergenceInterface<Float>* cdnet;
+    /** Number of replicas for data-parallel training,
+        1 = single-threaded, 0 = one per core */
+    size_t numThreads;
+    /** Multi-threaded validation */
+    std::unique_ptr<MNN::Evaluator<Float>> evaluator;
+    /** Writes saveAllLayers() in the background */
+    MNN::Checkpointer<Float> checkpointer;
 };
 
 TrainMnist::TrainMnist()
@@ -138,28 +161,33 @@ void TrainMnist::Private::loadSet()
 }
 
 const TrainMnist::Private::Float*
-TrainMnist::Private::getImage(DataSet &set, uint32_t num) const
+TrainMnist::Private::getImage(DataSet &set, uint32_t num)
+{
+    bufImage.resize(set.width() * set.height());
+    getImage(set, num, &bufImage[0]);
+    //printStateAscii(&bufImage[0], set.width(), set.height());
+    return &bufImage[0];
+}
+
+void TrainMnist::Private::getImage(const DataSet &set, uint32_t num, Float* output) const
 {
 #if 0
-    return set.image(num);
+    const Float* image = set.image(num);
+    std::copy(image, image + set.width() * set.height(), output);
 #elif 0
-    const Float *image = set.getNoisyBackgroundImage(
-                num, 0.4, MNN::rnd(-0.3, 0.3), MNN::rnd(0., 1.));
-    //printStateAscii(image, trainSet.width(), trainSet.height());
-    return image;
+    set.getNoisyBackgroundImage(
+                num, 0.4, MNN::rnd(-0.3, 0.3), MNN::rnd(0., 1.), output);
 #elif 1 && !defined(CIFAR)
-    return set.getTransformedImage(num, MNN::rnd(0.f, 4.f));
+    set.getTransformedImage(num, MNN::rnd(0.f, 4.f), output);
 #else
-    const Float *image = set.getNoisyImage(
-                num, MNN::rnd(-0.3, 0.), MNN::rnd(0., .3));
-    return image;
+    set.getNoisyImage(num, MNN::rnd(-0.3, 0.), MNN::rnd(0., .3), output);
 #endif
 }
 
 void TrainMnist::Private::saveAllLayers(const std::string& postfix)
 {
     std::cout << "saving '" << postfix << "'" << std::endl;
-    net.saveTextFile(postfix + "_stack.txt");
+    checkpointer.save(net, postfix + "_stack.txt");
 #if 0
     // save individual layers
     for (size_t i=0; i<net.numLayer(); ++i)
@@ -167,11 +195,35 @@ void TrainMnist::Private::saveAllLayers(const std::string& postfix)
         std::stringstream str;
         str << postfix << "_layer_" << i
             << "_" << net.layer(i)->numOut() << "h.txt";
-        net.layer(i)->saveTextFile(str.str());
+        checkpointer.save(*net.layer(i), str.str());
     }
 #endif
 }
 
+void TrainMnist::Private::saveIfBest()
+{
+    if (saved_error_count >= 0 && error_count >= size_t(saved_error_count))
+        return;
+
+    // save when error < x
+    if (error_count < 100)
+        saveAllLayers("../mnist_e100");
+    else if (error_count < 200)
+        saveAllLayers("../mnist_e200");
+    else if (error_count < 300)
+        saveAllLayers("../mnist_e300");
+    else if (error_count < 400)
+        saveAllLayers("../mnist_e400");
+    else if (error_count < 500)
+        saveAllLayers("../mnist_e500");
+    else if (error_count < 600)
+        saveAllLayers("../mnist_e600");
+    else if (error_count < 1000)
+        saveAllLayers("../mnist_e1000");
+
+    saved_error_count = error_count;
+}
+
 void TrainMnist::Private::createNet()
 {
     size_t numIn = trainSet.width() * trainSet.height(),
@@ -185,6 +237,7 @@ void TrainMnist::Private::createNet()
     saved_error_count = -1;
     numBatch = 1;
     doTrainCD = false;
+    numThreads = 1;
 
 #if 0
     // --- load autoencoder stack ----
@@ -548,6 +601,12 @@ void TrainMnist::Private::train()
 
 //    bool doGrow = true;
 
+    if (numThreads != 1 && !(doTrainCD && cdnet))
+    {
+        trainEpochs();
+        return;
+    }
+
     epoch = 0;
     while (true)
     {
@@ -592,26 +651,7 @@ void TrainMnist::Private::train()
         {
             testPerformance();
 #if 1
-            if (saved_error_count < 0 || error_count < size_t(saved_error_count))
-            {
-                // save when error < x
-                if (error_count < 100)
-                    saveAllLayers("../mnist_e100");
-                else if (error_count < 200)
-                    saveAllLayers("../mnist_e200");
-                else if (error_count < 300)
-                    saveAllLayers("../mnist_e300");
-                else if (error_count < 400)
-                    saveAllLayers("../mnist_e400");
-                else if (error_count < 500)
-                    saveAllLayers("../mnist_e500");
-                else if (error_count < 600)
-                    saveAllLayers("../mnist_e600");
-                else if (error_count < 1000)
-                    saveAllLayers("../mnist_e1000");
-
-                saved_error_count = error_count;
-            }
+            saveIfBest();
 #endif
             clearErrorCount();
         }
@@ -729,22 +769,61 @@ void TrainMnist::Private::trainLabelStep()
     net.bprop(&bufErr[0], NULL, learnRate);
 }
 
-template <class Net>
-int TrainMnist::Private::getLabelError(const Net& net, int label)
+void TrainMnist::Private::trainEpochs()
+{
+    // same augmentation as getImage(), on the trainer's threads
+    MNN::ClassifierDataSet<Float, DataSet> data(trainSet,
+        [this](const DataSet& set, size_t index, Float* output)
+        {
+            getImage(set, index, output);
+        });
+    MNN::Trainer<Float> trainer(net, data);
+    trainer.setMode(MNN::TM_DATA_PARALLEL);
+    trainer.setNumThreads(numThreads);
+    trainer.setBatchSize(numBatch * (numThreads ? numThreads : MNN::ThreadPool::numCores()));
+    trainer.setLearnRate(learnRate);
+    trainer.setReportInterval(5000);
+    trainer.setReportFunc([](const MNN::TrainerStats& stats)
+    {
+        stats.info();
+        std::cout << std::endl;
+    });
+
+    while (true)
+    {
+        trainer.trainEpoch();
+        testPerformance();
+        saveIfBest();
+        clearErrorCount();
+    }
+}
+
+int TrainMnist::Private::getAnswer(const Float* output, size_t num) const
 {
-    // get error from actual label number
     int answer = -1;
     Float ma = 0.;
-    for (size_t i=0; i<net.numOut(); ++i)
+    for (size_t i=0; i<num; ++i)
     {
-        Float o = net.output(i);
-        if (o > ma)
+        if (output[i] > ma)
         {
-            ma = o;
+            ma = output[i];
             answer = i;
         }
     }
+    return answer;
+}
 
+template <class Net>
+int TrainMnist::Private::getLabelError(const Net& net, int label)
+{
+    // get error from actual label number
+    int answer = getAnswer(net.outputs(), net.numOut());
+    addLabelError(answer, label);
+    return answer;
+}
+
+void TrainMnist::Private::addLabelError(int answer, int label)
+{
     // no label == 11, otherwise distance between
     // expected and performed digit
     error = answer < 0 ? 11. : std::abs(Float(answer - label));
@@ -763,8 +842,6 @@ int TrainMnist::Private::getLabelError(const Net& net, int label)
     else
         error_min = std::min(error_min, error);
     error_sum += error;
-
-    return answer;
 }
 
 void TrainMnist::Private::testPerformance()
@@ -774,31 +851,16 @@ void TrainMnist::Private::testPerformance()
     // select the test set
     auto& set = testSet;
 
-    // get a net copy
-    auto net = this->net.getCopy();
-    // set dropout mode to PERFORM
-    // Note: PERFORM mode is ignored for
-    // networks that havn't been trained with dropout
-    if (auto d = dynamic_cast<MNN::SetDropOutInterface<Float>*>(net))
-        d->setDropOutMode(MNN::DO_PERFORM);
+    // evaluate on all cores, sharing the net read-only
+    if (!evaluator)
+        evaluator.reset(new MNN::Evaluator<Float>());
+    MNN::ClassifierDataSet<Float, DataSet> data(set);
+    const auto& stats = evaluator->evaluate(net, data);
 
+    // gather min/max label distance
+    const auto& answers = evaluator->answers();
     for (size_t num=0; num < set.numSamples(); ++num)
-    {
-        uint8_t label = set.label(num);
-        const Float *image = set.image(num);
-
-        net->fprop(image, &bufOut[0]);
-
-        int answer = getLabelError(*net, label);
-        (void)answer;
-#if 0
-        if (error)
-        {
-            std::cout << "WRONG " << answer << " / " << (int)label << std::endl;
-            printStateAscii(image, testSet.width(), testSet.height());
-        }
-#endif
-    }
+        addLabelError(answers[num], set.label(num));
 
     Float error_percent = Float(error_count) / set.numSamples() * Float(100);
 
@@ -811,9 +873,8 @@ void TrainMnist::Private::testPerformance()
         std::cout << " " << std::setw(3) << errorsPerClass[j];
     std::cout << ", % " << error_percent
               << ", E " << error_count
+              << ", " << stats.seconds << "s"
               << std::endl;
-
-    delete net;
 }
 
 void TrainMnist::Private::runInputApproximation()
@@ -15,6 +15,30 @@
 #include "trainposition.h"
 #include "mnn/mnn.h"
 
+namespace {
+
+    /** Rows of target value followed by the input */
+    class PositionSet : public MNN::DataSetInterface<float>
+    {
+    public:
+        PositionSet(const std::vector<float>& data, size_t num, size_t rowLength)
+            : data_(data), num_(num), rowLength_(rowLength) { }
+
+        size_t numSamples() const override { return num_; }
+        size_t numIn() const override { return rowLength_ - 1; }
+        size_t numOut() const override { return 1; }
+        const float* input(size_t index) const override
+            { return &data_[index * rowLength_ + 1]; }
+        void expectedOutput(size_t index, float* output) const override
+            { *output = data_[index * rowLength_]; }
+
+    private:
+        const std::vector<float>& data_;
+        size_t num_, rowLength_;
+    };
+
+} // namespace
+
 TrainPosition::TrainPosition()
 {
     float lr = 0.006;
@@ -60,27 +84,23 @@ void TrainPosition::exec()
 
     net_->brainwash();
 
-    float output, error = 0.1, e;
-    size_t count = 0;
+    PositionSet set(data_, num_, entryLength_);
+    MNN::Trainer<float> trainer(*net_, set);
+    trainer.setReportFunc([](const MNN::TrainerStats& stats)
+    {
+        stats.info();
+        std::cout << "\n";
+    });
 
-    while (error > 0.01 && count<100000)
+    size_t count = 0;
+    while (count < 100000)
     {
-        // choose pattern
-        size_t nr = rand() % num_;
-        // feed forward
-        net_->fprop(&data_[nr * entryLength_ + 1], &output);
-        // compare
-        e = data_[nr * entryLength_] - output;
-        // average error over time
-        error += (fabs(e) - error) / 1000.f;
-        // train
-        net_->bprop(&e);
-        if (count % 5 == 0)
-            std::cout << "av. error " << error << " out " << output << "           \r";
-        //net.print();
-        count++;
+        const auto& stats = trainer.trainEpoch();
+        count += stats.numSamples;
+        if (stats.averageError() <= 0.01)
+            break;
     }
-    std::cout << "\ntook "<<count<<" epochs                                      \n";
+    std::cout << "took " << count << " steps\n";
 }
 
 void TrainPosition::test()